@@ -0,0 +1,50 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  ENGINE_EXTERN_CONCMD( bench_queue );
+  ENGINE_EXTERN_CONCMD( bench_spawn );
+  ENGINE_EXTERN_CONCMD( ai_sightcheck );
+
+  //! \class Benchmarks
+  //! Microbenchmarks & checks for engine primitives, run from the console.
+  class Benchmarks {
+  protected:
+    typedef SafeWaitableQueue<uint64_t> BenchQueue;
+    struct QueueProducer {
+      BenchQueue* queue;
+      uint64_t count; //!< Elements to push
+      HANDLE start; //!< Set to start pushing
+    };
+    static DWORD WINAPI queueProducerProc( void* argument );
+    //! Pushes count elements from producers threads & pops them all on the
+    //! calling thread.
+    //! \return Elapsed time in seconds.
+    static double runQueue( uint32_t producers, uint64_t count, long capacity );
+  public:
+    //! Console callbacks.
+    static void callbackQueue( Console* console,
+      ConCmd* command, StringVector& arguments );
+    static void callbackSpawn( Console* console,
+      ConCmd* command, StringVector& arguments );
+    static void callbackSightCheck( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Entity.h"
 #include "EntityRegistry.h"
 #include "Actions.h"
+#include "SceneQueries.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -126,26 +127,40 @@ namespace Glacier {
     Radian mFieldOfView;
     Real mViewDistance;
     Vector3 mFacing; //!< Local space normalized facing direction
+    static const uint32_t cMaxSightRays = 8;
+    struct SightProbe {
+      EntityHandle target;
+      SceneQueryTicket tickets[cMaxSightRays];
+      uint32_t count; //!< Rays in flight
+      bool visible; //!< Last answered verdict
+    };
+    mutable SightProbe mSight; //!< Line of sight to the last canSee target
     Character( World* world, const EntityBaseData* baseData,
       CharacterInputComponent* input );
     virtual ~Character();
   public:
     virtual Ogre::MovableObject* getMovable() = 0;
+    virtual physx::PxRigidActor* getActor();
     virtual const Vector3& getLocalEyePosition() const throw();
     virtual const Vector3 getWorldEyePosition() const throw();
     virtual const Radian& getFieldOfView() const throw();
     virtual const Vector3& getFacing() const throw();
+    //! Line of sight is raycast through the batched scene queries, so the
+    //! answer is that of the probe made on an earlier call for the same target.
+    //! If that probe's results have expired, the previous answer is kept.
     virtual const bool canSee( Entity* entity ) const throw();
+    //! Line of sight probed through the given scene queries instead.
+    const bool canSee( Entity* entity, SceneQueries* queries ) const throw();
     virtual void setActions( const ActionPacket& actions,
       const CharacterMoveMode mode,
       const Vector3& direction,
       const Vector2& directional );
     virtual void spawn( const Vector3& position, const Quaternion& orientation );
     virtual void think( const GameTime delta );
+    virtual void postthink( const GameTime delta );
     virtual void onHitGround();
     virtual void onLeaveGround();
     virtual const bool isOnGround();
-    virtual void visualize();
   };
 
   class PlayerCharacterInputComponent: public CharacterInputComponent {
@@ -192,6 +207,8 @@ namespace Glacier {
       Vector3 position;
       GroundQuery(): hit( false ), position( Vector3::ZERO ) {}
     };
+    GroundQuery mGround; //!< Last answered ground probe
+    SceneQueryTicket mGroundTicket; //!< Ground probe in flight
   public:
     CharacterPhysicsComponent( World* world, const Vector3& position, const Real height, const Real radius );
     virtual const Real getHeight() const throw() { return mHeight; }
@@ -202,6 +219,8 @@ namespace Glacier {
     virtual void setPosition( const Vector3& position );
     virtual const physx::PxControllerCollisionFlags& move( const Vector3& displacement, const GameTime delta );
     virtual const physx::PxControllerCollisionFlags& getLastCollisionFlags() const throw( ) { return mCollisionFlags; }
+    //! Queues a ground probe below the given position and returns the most
+    //! recent answered probe, i.e. one made on an earlier logic step.
     virtual GroundQuery groundQuery( const Vector3& position );
     virtual const Real getOffsetFromGround();
     virtual void update();
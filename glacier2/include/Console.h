@@ -141,6 +141,11 @@ namespace Glacier {
   //! A list of console listeners.
   typedef std::list<ConsoleListener*> ConsoleListenerList;
 
+  const size_t cConsoleBufferSize = 256; //!< Buffered command capacity, power of two
+
+  //! Lock-free buffer of command lines for next execution.
+  typedef BoundedMPSCQueue<wstring, cConsoleBufferSize> CommandBuffer;
+
   //! \class Console
   //! Allows output of messages and execution of commands and variables.
   //! \sa EngineComponent
@@ -160,11 +165,11 @@ namespace Glacier {
     };
   protected:
     Platform::RWLock mLock; //!< Execution lock
-    Platform::RWLock mBufferLock; //!< Command buffer lock
     ConBaseList mCommands; //!< Registered commands & variables
     static ConBaseList mPrecreated; //!< Pre-created commands & variables
     StringList mLines; //!< Line buffer
-    StringQueue mCommandBuffer; //!< Command buffer for next execution
+    CommandBuffer mCommandBuffer; //!< Command buffer for next execution
+    wstring mBufferedLine; //!< Line popped off the command buffer
     std::map<Source,ConsoleSource> mSources;
     TextFile* mOutFile; //!< Output log file
     ConsoleListenerList mListeners; //!< Console event listeners
@@ -192,6 +197,7 @@ namespace Glacier {
     //! Registers a message source.
     Source registerSource( const wstring& name, COLORREF color );
     //! Processes commands currently in the command buffer.
+    //! Main thread only.
     void processBuffered();
     //! Adds a listener.
     void addListener( ConsoleListener* listener );
@@ -210,6 +216,7 @@ namespace Glacier {
     //! Executes a command line.
     void execute( wstring commandLine, const bool echo = true );
     //! Queues a command for execution on next update call.
+    //! Safe from any thread, never blocks.
     void executeBuffered( const wstring& commandLine );
     //! Executes a file.
     void executeFile( const wstring& filename );
@@ -83,6 +83,10 @@ namespace Glacier {
     virtual void start();
     //! Stops this ConsoleWindowThread.
     virtual void stop();
+    //! Gets the thread handle.
+    HANDLE getThread() { return mThread; }
+    //! Gets the thread identifier.
+    DWORD getThreadID() { return mThreadID; }
     //! Destructor.
     ~ConsoleWindowThread();
   };
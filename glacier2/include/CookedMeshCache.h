@@ -0,0 +1,133 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+#include "ThreadController.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Physics
+  //! @{
+
+  ENGINE_EXTERN_CONCMD( px_meshcache );
+
+  class CookedMeshCache;
+
+  //! Cache key, a hash of the source geometry & cooking parameters.
+  typedef uint64_t CookedMeshKey;
+
+  enum CookedMeshType {
+    CookedMesh_Triangle = 0, //!< PxTriangleMesh from a triangle list
+    CookedMesh_Convex //!< PxConvexMesh computed as the hull of the vertices
+  };
+
+  //! \struct MeshSource
+  //! Source geometry to cook.
+  struct MeshSource {
+    CookedMeshType type;
+    vector<physx::PxVec3> vertices;
+    vector<uint32_t> indices; //!< Three per triangle, ignored for convex meshes
+  };
+
+  //! \class MeshCooker
+  //! Background thread cooking the cache's queued meshes.
+  class MeshCooker: public ThreadController {
+  protected:
+    CookedMeshCache* mCache;
+    virtual void onStart();
+    virtual void onStep();
+    virtual void onPreStop();
+    virtual void onStop();
+  public:
+    MeshCooker( CookedMeshCache* cache );
+    HANDLE getThread() { return mThread; }
+    virtual ~MeshCooker();
+  };
+
+  //! \class CookedMeshCache
+  //! Cooked collision meshes keyed by a hash of their source geometry and
+  //! the cooking parameters. Cooking happens on a background thread, and
+  //! cooked streams are kept on disk so that repeated loads, even across
+  //! runs, skip cooking entirely. Meshes are created once and shared by
+  //! every caller asking for the same geometry.
+  class CookedMeshCache: boost::noncopyable {
+  friend class MeshCooker;
+  public:
+    enum State {
+      State_Queued, //!< Waiting for the cooker
+      State_Ready, //!< Cooked stream or mesh available
+      State_Failed //!< Cooking failed
+    };
+  protected:
+    struct Entry {
+      CookedMeshKey key;
+      CookedMeshType type;
+      volatile State state;
+      MeshSource* source; //!< Held until cooked
+      vector<uint8_t> stream; //!< Cooked data, dropped once the mesh exists
+      physx::PxBase* mesh; //!< Shared mesh, created on first acquire
+    };
+    struct Stats {
+      uint64_t memoryHits; //!< Requests answered by an existing entry
+      uint64_t diskHits; //!< Entries loaded from disk
+      uint64_t cooked; //!< Entries cooked
+      uint64_t failed; //!< Entries failed to cook
+    };
+    physx::PxPhysics* mPhysics;
+    physx::PxCooking* mCooking;
+    uint64_t mParameterHash; //!< Hash of the cooking parameters & SDK version
+    wstring mDirectory; //!< Disk cache directory
+    std::map<CookedMeshKey, Entry*> mEntries;
+    std::deque<Entry*> mQueue; //!< Entries waiting for the cooker
+    Platform::RWLock mLock; //!< Guards entries & queue
+    HANDLE mCookedEvent; //!< Signaled whenever the cooker finishes an entry
+    MeshCooker* mCooker;
+    Stats mStats;
+    CookedMeshKey hash( const MeshSource& source ) const;
+    const wstring getFilename( const CookedMeshKey key ) const;
+    bool load( Entry* entry );
+    bool save( Entry* entry );
+    bool cook( Entry* entry );
+    void cookQueued(); //!< Cooker thread
+    Entry* request( const MeshSource& source );
+    physx::PxBase* acquire( const MeshSource& source );
+  public:
+    //! Constructor.
+    //! \param  physics    The physics SDK, to create meshes.
+    //! \param  cooking    The cooker, used only from the cooker thread.
+    //! \param  parameters The parameters the cooker was created with.
+    //! \param  directory  Disk cache directory.
+    CookedMeshCache( physx::PxPhysics* physics, physx::PxCooking* cooking,
+      const physx::PxCookingParams& parameters, const wstring& directory );
+    MeshCooker* getCooker() { return mCooker; }
+    //! Queues a mesh for background cooking, unless it's already cached.
+    CookedMeshKey prefetch( const MeshSource& source );
+    //! Gets the state of a prefetched mesh, State_Failed for unknown keys.
+    const State getState( const CookedMeshKey key );
+    //! Gets a shared triangle mesh, waiting for it to cook if necessary.
+    //! The cache owns the mesh; shapes using it hold their own references.
+    physx::PxTriangleMesh* acquireTriangleMesh( const MeshSource& source );
+    //! Gets a shared convex mesh, waiting for it to cook if necessary.
+    //! The cache owns the mesh; shapes using it hold their own references.
+    physx::PxConvexMesh* acquireConvexMesh( const MeshSource& source );
+    //! Waits for all queued meshes to finish cooking.
+    void flush();
+    //! Drops all entries from memory. Disk entries are kept.
+    void clear();
+    ~CookedMeshCache();
+    //! Console callback.
+    static void callbackStats( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace Glacier {
   class Director;
   class PhysicsScene;
   class PhysicsDebugVisualizer;
+  struct ImportedCollection;
 
   namespace Primitives {
     class Primitive;
@@ -19,8 +20,10 @@ namespace Glacier {
   protected:
     Director* mDirector;
     std::list<Primitives::Primitive*> mPrimitives;
+    ImportedCollection* mLevelPhysics; //!< Level actors, if imported
     class NavigationMesh* mNavigationMesh;
     class NavigationDebugVisualizer* mNavVis;
+    void buildNavigation();
   public:
     DemoState();
     Director* getDirector() { return mDirector; }
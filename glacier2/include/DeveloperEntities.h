@@ -18,21 +18,25 @@ namespace Glacier {
         DevCube_025,
         DevCube_050
       };
+      static const int cTypeCount = 2;
     private:
       static EntityBaseData baseData;
     protected:
+      static Ogre::MeshPtr fMeshes[cTypeCount]; //!< Shared by all cubes of a type
+      static uint32_t fMeshUsers[cTypeCount];
       physx::PxRigidDynamic* mActor;
       Ogre::Item* mItem;
-      Ogre::MeshPtr mMesh;
       Type mType;
       DevCube( World* world );
       virtual ~DevCube();
     public:
       virtual Ogre::MovableObject* getMovable();
+      virtual physx::PxRigidActor* getActor();
       virtual void setType( const Type type );
+      //! Takes a pointer to a Type.
+      virtual void configure( const void* parameters );
       virtual void spawn( const Vector3& position, const Quaternion& orientation );
       virtual void think( const GameTime delta );
-      virtual void visualize();
     };
 
   }
@@ -24,14 +24,19 @@ namespace Glacier {
     Ogre::SceneNode* mEyeNode;
     AI::FiniteStateMachine mStates;
     FOVCone mFovCone;
+    EntityHandle mTarget; //!< Entity we're watching for
     Dummy( World* world );
     virtual ~Dummy();
   public:
     virtual AICharacterInputComponent* getInput();
     FOVCone& getFOVCone() throw();
+    //! Gets the entity we're watching for, looking it up again by name
+    //! only when the handle has gone stale.
+    Entity* getTarget();
     virtual void spawn( const Vector3& position, const Quaternion& orientation );
+    virtual void prethink( const GameTime delta );
     virtual void think( const GameTime delta );
-    virtual void visualize();
+    virtual void visualize( const GameTime alpha );
     virtual Ogre::MovableObject* getMovable();
   };
 
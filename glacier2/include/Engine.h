@@ -27,11 +27,21 @@ namespace Glacier {
   class EntityManager;
   class World;
   class Navigation;
+  class JobSystem;
+  class TickScheduler;
+  class FrameGovernor;
+  class FrameStatistics;
+  class ThreadPlacement;
+  class EngineComponent;
+  struct Job;
 
   ENGINE_EXTERN_CONCMD( version );
   ENGINE_EXTERN_CONCMD( memstat );
   ENGINE_EXTERN_CONCMD( screenshot );
   ENGINE_EXTERN_CONCMD( quit );
+  ENGINE_EXTERN_CONVAR( eng_tickrate );
+  ENGINE_EXTERN_CONVAR( eng_unthrottled );
+  ENGINE_EXTERN_CONVAR( eng_timelimit );
 
   //! \class Engine
   //! The main engine class that makes the world go round
@@ -47,6 +57,13 @@ namespace Glacier {
       Fatal_Generic, //!< Non-specific fatal error case
       Fatal_MemoryAllocation //!< Memory allocation failure
     };
+    //! Tick scheduler slots for components not running at the base rate
+    enum TickSlot {
+      TickSlot_Input = 0, //!< Input devices
+      TickSlot_Game,      //!< Game state
+      TickSlot_AI,        //!< Entity prethink
+      TickSlot_Audio      //!< Sound engine
+    };
     //! Engine version structure
     struct Version {
       uint32_t major;   //!< The major version
@@ -63,6 +80,7 @@ namespace Glacier {
     struct Options {
       bool noAudio;
       bool noPhysics;
+      bool headless; //!< No window, graphics, input or audio
       StringList additionalExecs;
       Options();
     };
@@ -81,18 +99,34 @@ namespace Glacier {
     EntityManager* mEntities;
     World* mWorld;
     Navigation* mNavigation;
+    JobSystem* mJobs;
+    Ogre::Root* mHeadlessRoot; //!< Resource-only Ogre root when headless
+    bool mHeadless;
+    TickScheduler* mScheduler;
+    FrameGovernor* mGovernor;
+    FrameStatistics* mFrameStats;
+    ThreadPlacement* mPlacement;
     // Timing
     LARGE_INTEGER mHPCFrequency;        //!< HPC frequency
     static GameTime fTime;              //!< Game time
     static GameTime fTimeDelta;         //!< Game frame delta
     static GameTime fTimeAccumulator;   //!< Game frametime accumulator
     static GameTime fLogicStep;         //!< Game logic step
+    static GameTime fTimeAlpha;         //!< Render interpolation factor
     // Handles
     HANDLE mProcess;                    //!< Process handle
     HANDLE mThread;                     //!< Main thread handle
     HINSTANCE mInstance;                //!< Instance handle
     volatile Signal mSignal;            //!< Engine signal
     void fixupThreadAffinity();
+    uint32_t getJobWorkerCount();
+    //! Step job running a component tick off the main thread.
+    struct ComponentTickJob {
+      EngineComponent* component;
+      GameTime tick;
+      GameTime time;
+    };
+    static void componentTickJob( Job* job, const void* data );
   public:
     // Getters
     const Version& getVersion() { return mVersion; }
@@ -106,7 +140,16 @@ namespace Glacier {
     EntityManager* getEntities() { return mEntities; }
     World* getWorld() { return mWorld; }
     Navigation* getNavigation() { return mNavigation; }
+    JobSystem* getJobs() { return mJobs; }
+    TickScheduler* getScheduler() { return mScheduler; }
+    FrameGovernor* getGovernor() { return mGovernor; }
+    FrameStatistics* getFrameStats() { return mFrameStats; }
+    ThreadPlacement* getPlacement() { return mPlacement; }
     inline GameTime getTime() { return fTime; }
+    inline bool isHeadless() { return mHeadless; }
+    //! Get the fraction of a logic step elapsed since the last one, [0,1).
+    //! Used to blend visuals between the previous and current logic step.
+    inline GameTime getInterpolation() { return fTimeAlpha; }
     // Callbacks
     static void callbackVersion( Console* console,
       ConCmd* command, StringVector& arguments );
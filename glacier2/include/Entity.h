@@ -8,12 +8,48 @@ namespace Glacier {
   class World;
   class PhysicsScene;
   class EntityManager;
+  class EntityPool;
   struct EntityBaseData;
 
   namespace JS {
     class Entity;
   }
 
+  const uint32_t cInvalidEntityIndex = 0xFFFFFFFF; //!< Unused slot or thinker index
+
+  //! \struct EntityHandle
+  //! Generational reference to an entity. Unlike a pointer, a handle to a
+  //! removed entity is detected as stale in constant time.
+  //! Generations start at one, so a zeroed handle is never valid.
+  struct EntityHandle {
+    uint32_t index; //!< Slot index
+    uint32_t generation; //!< Slot generation at creation
+    EntityHandle(): index( 0 ), generation( 0 ) {}
+    EntityHandle( uint32_t index_, uint32_t generation_ ):
+    index( index_ ), generation( generation_ ) {}
+    inline bool isNull() const throw() { return generation == 0; }
+    inline uint64_t getValue() const throw() { return ( (uint64_t)generation << 32 ) | index; }
+    inline bool operator == ( const EntityHandle& other ) const throw()
+    {
+      return ( index == other.index && generation == other.generation );
+    }
+    inline bool operator != ( const EntityHandle& other ) const throw()
+    {
+      return !( *this == other );
+    }
+  };
+
+  //! Interned entity tag, see EntityManager::getTag.
+  typedef uint32_t EntityTag;
+
+  //! An entity's membership in a tag index.
+  struct EntityTagSlot {
+    EntityTag tag;
+    uint32_t index; //!< Index in the tag's entity list
+  };
+
+  typedef vector<EntityTagSlot> EntityTagSlotVector;
+
   class Entity {
   friend class EntityManager;
   private:
@@ -22,27 +58,54 @@ namespace Glacier {
     World* mWorld;
     string mName; //!< Entity name
     SceneNode* mNode; //!< Entity root node
-    Vector3 mPosition; //!< World position
-    Quaternion mOrientation; //!< World orientation
+    uint32_t mTransform; //!< Slot in the world's transform store
+    bool mVisualizes; //!< Whether visualize() needs to be called
+    bool mThreadedThink; //!< Whether think() may run on a job thread
     JS::Entity* mScriptable;
     bool mRemoval;
+    EntityHandle mHandle; //!< Own handle, assigned by the manager
+    EntityPool* mPool; //!< Pool we were constructed in, assigned by the manager
+    uint32_t mThinkerIndex; //!< Index in the manager's thinkers
+    uint32_t mThinkInterval; //!< Logic steps between thinks, 0 = never
+    bool mSleeping; //!< Not thinking until woken
+    uint32_t mWakeDelay; //!< Logic steps until a sleeper wakes, 0 = until woken
+    uint32_t mThinkTicket; //!< Bumped on reschedule to invalidate wheel entries
+    bool mScheduleDirty; //!< Queued for rescheduling
+    uint32_t mClassIndex; //!< Index in the manager's class index
+    EntityTagSlotVector mTagSlots; //!< Tags in the manager's tag index
     explicit Entity( World* world, const EntityBaseData* baseData );
     virtual ~Entity();
     void setName( const string& name ) { mName = name; }
     void markForRemoval() { mRemoval = true; }
+    void setThinkInterval( const uint32_t steps ); //!< Think every n logic steps, 0 = never
+    void sleep(); //!< Stop thinking until woken
+    void wakeAfter( const uint32_t steps ); //!< Stop thinking for n logic steps
+    void storeTransform();
+    void setPosition( const Vector3& position );
+    void setOrientation( const Quaternion& orientation );
+    const Vector3 getInterpolatedPosition( const GameTime alpha ) const;
+    const Quaternion getInterpolatedOrientation( const GameTime alpha ) const;
   public:
     inline const JS::Entity* getScriptable() const throw( ) { return mScriptable; }
     inline const EntityBaseData& getBaseData() const throw( ) { return *mBaseData; }
     inline const World* getWorld() const throw( ) { return mWorld; }
     inline const string& getName() const throw( ) { return mName; }
+    inline const EntityHandle getHandle() const throw( ) { return mHandle; }
+    const bool hasTag( const EntityTag tag ) const throw( );
     inline const bool isRemoval() const throw( ) { return mRemoval; }
-    inline const Vector3& getPosition() const throw( ) { return mPosition; }
-    inline const Quaternion& getOrientation() const throw( ) { return mOrientation; }
+    inline const bool isSleeping() const throw( ) { return mSleeping; }
+    void wake(); //!< Resume thinking, e.g. on an event
+    const Vector3 getPosition() const throw( );
+    const Quaternion getOrientation() const throw( );
     inline SceneNode* getNode() throw( ) { return mNode; }
     virtual Ogre::MovableObject* getMovable() = 0;
+    virtual physx::PxRigidActor* getActor(); //!< Physics actor standing in for this entity in scene queries, if any
+    virtual void configure( const void* parameters ); //!< Apply class specific spawn parameters, called before spawn in batches
     virtual void spawn( const Vector3& position, const Quaternion& orientation );
-    virtual void think( const GameTime delta ) = 0;
-    virtual void visualize() = 0; //!< Apply ALL VISUAL (e.g. Node) translations here, and not before!
+    virtual void prethink( const GameTime delta ); //!< AI, runs at ai_tickrate while physics is simulating, do NOT touch the physics scene here!
+    virtual void think( const GameTime delta ) = 0; //!< If mThreadedThink is set, runs in parallel with other entities: mutate only this entity, including its transform, and others only through EntityManager::defer*
+    virtual void postthink( const GameTime delta ); //!< Runs serially after all entities have thought, touch the physics scene here
+    virtual void visualize( const GameTime alpha ); //!< Apply visuals beyond the synced node transform here, only called if mVisualizes is set!
     void remove();
   };
 
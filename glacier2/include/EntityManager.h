@@ -1,23 +1,147 @@
 #pragma once
 #include "Entity.h"
+#include "Console.h"
+#include <unordered_map>
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
 
 namespace Glacier {
 
+  ENGINE_EXTERN_CONVAR( ai_tickrate );
+  ENGINE_EXTERN_CONVAR( ent_parallelthink );
+  ENGINE_EXTERN_CONVAR( ent_thinkbatch );
+  ENGINE_EXTERN_CONVAR( ent_poolchunk );
+  ENGINE_EXTERN_CONCMD( ent_think );
+  ENGINE_EXTERN_CONCMD( ent_pools );
+  ENGINE_EXTERN_CONCMD( ent_reserve );
+
   class World;
+  class EntityPool;
+  struct EntityRecord;
+
+  const size_t cThinkWheelSize = 256; //!< Timing wheel steps, power of two
+
+  typedef vector<Entity*> EntityVector;
+  typedef vector<EntityHandle> EntityHandleVector;
+
+  //! \struct EntitySpawn
+  //! One entity in a batch, see EntityManager::spawnBatch.
+  struct EntitySpawn {
+    string className; //!< In-game entity class name
+    Vector3 position;
+    Quaternion orientation;
+    const void* parameters; //!< Class specific, passed to Entity::configure
+    EntitySpawn( const string& className_, const Vector3& position_,
+      const Quaternion& orientation_, const void* parameters_ = nullptr ):
+    className( className_ ), position( position_ ),
+    orientation( orientation_ ), parameters( parameters_ ) {}
+  };
+
+  typedef vector<EntitySpawn> EntitySpawnVector;
 
-  typedef std::list<Entity*> EntityList;
+  //! Deferred cross-entity call, see EntityManager::deferCall.
+  typedef void ( *EntityCallback )( Entity* entity, void* context );
 
+  //! \class EntityManager
+  //! Owns all entities in a slot map. Entities are addressed by generational
+  //! handles through the slots, while the entities themselves are kept in
+  //! dense arrays for iteration. Insert, remove & lookup are O(1).
+  //! Name, class & tag indices are hashed; the name & class indices are
+  //! keyed by the entities' own strings, so names are stored only once.
+  //! With ent_parallelthink, threaded thinkers run in batches on the job
+  //! system. Spawns, removals & calls made meanwhile are queued per thread
+  //! and applied at the sync point before the serial postthink phase.
+  //! Entities are constructed into per-class pools and their memory is
+  //! recycled on removal.
+  //! Entities thinking on every step are kept in a dense set. Entities
+  //! thinking less often, and sleepers with a wake timer, are kept on a
+  //! timing wheel instead, spread over its steps to even out the work.
+  //! Schedule changes take effect at the start of the next logic step.
   class EntityManager: public EngineComponent {
   protected:
+    struct DeferredCommand {
+      enum Type {
+        Command_Spawn,
+        Command_Remove,
+        Command_Call,
+        Command_Reschedule
+      } type;
+      EntityHandle target; //!< Remove & call target
+      string className; //!< Spawned class
+      Vector3 position; //!< Spawn position
+      Quaternion orientation; //!< Spawn orientation
+      EntityCallback callback; //!< Call function
+      void* context; //!< Call context
+    };
+    typedef vector<DeferredCommand> CommandBuffer;
+    typedef std::unordered_map<const EntityRecord*, EntityPool*> PoolMap;
+    struct WheelEntry {
+      EntityHandle handle;
+      uint32_t ticket; //!< Entity's think ticket when scheduled, stale if changed
+      uint64_t due; //!< Step due on
+    };
+    typedef vector<WheelEntry> WheelBucket;
+    struct StringKey {
+      const string* str;
+    };
+    struct StringKeyHash {
+      size_t operator()( const StringKey& key ) const { return std::hash<string>()( *key.str ); }
+    };
+    struct StringKeyEqual {
+      bool operator()( const StringKey& a, const StringKey& b ) const { return *a.str == *b.str; }
+    };
+    typedef std::unordered_map<StringKey, Entity*, StringKeyHash, StringKeyEqual> NameIndex;
+    typedef std::unordered_map<StringKey, EntityVector, StringKeyHash, StringKeyEqual> ClassIndex;
+    typedef std::unordered_map<string, EntityTag> TagNameMap;
+    struct Slot {
+      Entity* entity; //!< Null when free
+      uint32_t generation; //!< Bumped whenever the slot is freed
+      uint32_t next; //!< Index in mEntities when used, next free slot when free
+    };
     World* mWorld;
     uint64_t mNamingCounter;
-    EntityList mEntities;
-    EntityList mThinkers;
-    EntityList mRemovals;
-    string nextEntityName();
+    vector<Slot> mSlots; //!< Handle slots
+    uint32_t mFreeSlot; //!< Head of the free slot list
+    EntityVector mEntities; //!< Dense, unordered
+    EntityVector mThinkers; //!< Dense, unordered, think on every step
+    WheelBucket mWheel[cThinkWheelSize]; //!< Timed thinks & wakes by step
+    WheelBucket mWheelScratch; //!< Bucket being advanced
+    EntityVector mDue; //!< Wheel thinkers due on the current step, from beginStep
+    EntityHandleVector mRescheduled; //!< Entities whose schedule changed
+    uint64_t mStep; //!< Logic step counter
+    EntityHandleVector mRemovals;
+    NameIndex mNames; //!< Entities by name
+    ClassIndex mClasses; //!< Entities by class name
+    TagNameMap mTagNames; //!< Interned tags by name
+    vector<EntityVector> mTags; //!< Entities by tag
+    string mAnonymousName; //!< Scratch for generated names
+    PoolMap mPools; //!< Entity memory by class
+    vector<CommandBuffer> mCommandBuffers; //!< Deferred commands per job thread
+    volatile bool mDeferring; //!< Whether thinkers are running in parallel
+    GameTime mThinkDelta; //!< Tick of the parallel think in progress
+    static const EntityVector cNoEntities;
+    EntityPool* getPool( const EntityRecord* record );
+    Entity* construct( const EntityRecord* record, const string& name );
+    void applySchedules();
+    void applySchedule( Entity* entity );
+    void schedule( Entity* entity, uint64_t due );
+    void advanceWheel();
+    inline size_t getStepThinkerCount() const throw() { return mDue.size() + mThinkers.size(); }
+    //! Due wheel thinkers come first, so that entities appended to the
+    //! dense set while thinking don't shift them.
+    inline Entity* getStepThinker( size_t index ) const throw()
+    {
+      return ( index < mDue.size() ? mDue[index] : mThinkers[index - mDue.size()] );
+    }
+    const string& nextAnonymousName();
+    CommandBuffer& getCommandBuffer();
+    void applyDeferred();
+    static void thinkRange( size_t begin, size_t end, void* context );
+    EntityHandle allocate( Entity* entity );
+    void release( const EntityHandle handle );
+    void index( Entity* entity );
+    void unindex( Entity* entity );
     void addThinker( Entity* entity );
     void removeThinker( Entity* entity );
     void remove( Entity* entity );
@@ -26,13 +150,61 @@ namespace Glacier {
     EntityManager( Engine* engine, World* world );
     Entity* create( const string& className, const string& name );
     Entity* create( const string& className );
+    //! Creates entities for a batch of spawns with anonymous names,
+    //! reserving storage for all of them at once.
+    void createBatch( const EntitySpawn* spawns, size_t count, EntityVector& created );
+    //! Creates, configures & spawns a batch of entities. Physics actors
+    //! added by the spawns are inserted into the scene in one go.
+    void spawnBatch( const EntitySpawn* spawns, size_t count, EntityVector* spawned = nullptr );
+    //! Marks an entity for removal at the start of the next logic step.
     void markForRemoval( Entity* entity );
+    //! Creates & spawns an entity, deferred to the sync point while
+    //! thinking in parallel.
+    void deferSpawn( const string& className, const Vector3& position,
+      const Quaternion& orientation );
+    //! Calls back with the target entity, deferred to the sync point while
+    //! thinking in parallel. Use this to mutate other entities from think.
+    //! The callback is skipped if the target has been removed meanwhile.
+    void deferCall( const EntityHandle target, EntityCallback callback,
+      void* context );
+    //! Marks an entity's think interval or sleep state as changed.
+    void reschedule( Entity* entity );
+    //! Query whether thinkers are running in parallel.
+    inline bool isDeferring() const throw() { return mDeferring; }
     void removeMarked();
+    //! Removes all entities and frees their pools' memory.
     void clear();
+    //! Preallocates memory for count entities of a class.
+    void reserve( const string& className, size_t count );
     Entity* findByName( const string& name );
+    //! Gets all entities of a class.
+    const EntityVector& findByClass( const string& className );
+    //! Interns a tag name, returning the same tag for the same name.
+    EntityTag getTag( const string& name );
+    void addTag( Entity* entity, const EntityTag tag );
+    void removeTag( Entity* entity, const EntityTag tag );
+    //! Gets all entities with a tag.
+    const EntityVector& findByTag( const EntityTag tag );
+    //! Resolves a handle.
+    //! \return The entity, or null if the handle is stale or null.
+    Entity* get( const EntityHandle handle );
+    //! Query whether a handle refers to a live entity.
+    inline bool isValid( const EntityHandle handle ) { return get( handle ) != nullptr; }
+    inline size_t getCount() const throw() { return mEntities.size(); }
+    //! Applies changed schedules & collects the wheel thinkers due on this
+    //! step, before anything runs entity code on it.
+    void beginStep();
+    void prethink( GameTime tick, GameTime time );
     virtual void componentPreUpdate( GameTime time );
     virtual void componentTick( GameTime tick, GameTime time );
     virtual void componentPostUpdate( GameTime delta, GameTime time );
+    //! Console callbacks.
+    static void callbackThink( Console* console,
+      ConCmd* command, StringVector& arguments );
+    static void callbackPools( Console* console,
+      ConCmd* command, StringVector& arguments );
+    static void callbackReserve( Console* console,
+      ConCmd* command, StringVector& arguments );
     virtual ~EntityManager();
   };
 
@@ -0,0 +1,56 @@
+#pragma once
+#include "Types.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  const size_t cEntityPoolAlignment = 16; //!< Block alignment in bytes
+
+  //! \class EntityPool
+  //! Fixed-size block pool for one entity class. Blocks are carved from
+  //! chunks allocated in the entity memory sector and recycled through an
+  //! intrusive free list, so spawn & despawn churn never touches the heap.
+  //! Objects are constructed into blocks in place, and must be destructed
+  //! before their block is recycled.
+  class EntityPool: boost::noncopyable {
+  protected:
+    size_t mBlockSize; //!< Object size rounded up to alignment
+    size_t mChunkSize; //!< Blocks per chunk
+    vector<void*> mChunks; //!< Allocated chunks
+    void* mFree; //!< Head of the free list
+    size_t mCapacity; //!< Total blocks
+    size_t mUsed; //!< Blocks in use
+    void grow( size_t count );
+  public:
+    //! Constructor.
+    //! \param  objectSize  Size of the pooled class.
+    //! \param  chunkSize   Blocks to allocate at once when growing.
+    EntityPool( size_t objectSize, size_t chunkSize );
+    //! Gets a free block, growing the pool if necessary.
+    void* acquire();
+    //! Returns a block whose object has been destructed.
+    void recycle( void* block );
+    //! Makes sure at least count blocks exist.
+    void reserve( size_t count );
+    //! Frees all chunks at once. All objects must have been destructed.
+    void release();
+    inline size_t getBlockSize() const throw() { return mBlockSize; }
+    inline size_t getCapacity() const throw() { return mCapacity; }
+    inline size_t getUsed() const throw() { return mUsed; }
+    inline size_t getChunkCount() const throw() { return mChunks.size(); }
+    ~EntityPool();
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
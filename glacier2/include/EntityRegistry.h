@@ -11,7 +11,8 @@ namespace Glacier {
   class World;
   class Entity;
 
-  typedef Entity* ( *fnEntityFactory )( World* world );
+  //! Constructs an entity into memory of at least the record's size.
+  typedef Entity* ( *fnEntityFactory )( World* world, void* memory );
 
   //! \struct EntityBaseData
   //! \brief Static base data for every derived entity class.
@@ -28,10 +29,11 @@ namespace Glacier {
   struct EntityRecord {
     string name; //!< In-game entity class name, such as "prop_static"
     string className; //!< Entity class name in code, such as "PropStatic"
+    size_t size; //!< Size of the entity class in bytes
     fnEntityFactory factory; //!< Pointer to the factory function
-    EntityRecord( const string& name_, const string& class_,
+    EntityRecord( const string& name_, const string& class_, size_t size_,
       fnEntityFactory factory_ ): name( name_ ), className( class_ ),
-      factory( factory_ ) {}
+      size( size_ ), factory( factory_ ) {}
   };
 
   typedef std::map<string, EntityRecord*> EntityRecordMap;
@@ -46,7 +48,7 @@ namespace Glacier {
   public:
     ~EntityRegistry();
     void declare( const string& name, const string& className,
-      fnEntityFactory factory );
+      size_t size, fnEntityFactory factory );
     EntityRecord* lookup( const string& name );
     void clear();
   };
@@ -60,8 +62,8 @@ namespace Glacier {
   class EntityFactories {
   public:
     template <class T>
-    static Entity* factory( World* world ) {
-      return static_cast<Entity*>( new T( world ) );
+    static Entity* factory( World* world, void* memory ) {
+      return static_cast<Entity*>( new ( memory ) T( world ) );
     }
   };
 
@@ -75,7 +77,7 @@ namespace Glacier {
     explicit EntityRegistrar( const string& name, const string& className,
     fnEntityFactory factory )
     {
-      EntityRegistry::instance().declare( name, className, factory );
+      EntityRegistry::instance().declare( name, className, sizeof( T ), factory );
     }
   };
 
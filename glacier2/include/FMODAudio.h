@@ -12,6 +12,7 @@ namespace Glacier {
   ENGINE_EXTERN_CONVAR( fm_maxchannels );
   ENGINE_EXTERN_CONVAR( fm_speakermode );
   ENGINE_EXTERN_CONVAR( fm_outputmode );
+  ENGINE_EXTERN_CONVAR( fm_tickrate );
   ENGINE_EXTERN_CONCMD( fm_restart );
 
   class FMODMusic;
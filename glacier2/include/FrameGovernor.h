@@ -0,0 +1,86 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  ENGINE_EXTERN_CONVAR( eng_maxsteps );
+  ENGINE_EXTERN_CONVAR( eng_framebudget );
+  ENGINE_EXTERN_CONCMD( eng_governor );
+
+  class Engine;
+
+  //! Deferrable work entry point.
+  typedef void ( *DeferredFunction )( void* context );
+
+  const size_t cMaxDeferredWork = 1024; //!< Deferred work queue capacity
+  const uint64_t cMaxDeferralFrames = 30; //!< Frames before work is forced through
+
+  //! \class FrameGovernor
+  //! Keeps the main loop within its per-frame CPU budget.
+  //! Limits the number of catch-up logic steps per frame, dropping the excess
+  //! time, and runs low-priority deferred work only while the frame has slack.
+  class FrameGovernor: boost::noncopyable {
+  protected:
+    struct DeferredWork {
+      DeferredFunction function;
+      void* context;
+      uint64_t frame; //!< Frame the work was posted on
+    };
+    struct Statistics {
+      uint64_t frames; //!< Frames governed, written under the queue lock
+      uint64_t overBudget; //!< Frames that ran out of budget
+      uint64_t stepsDropped; //!< Logic steps dropped by the catch-up limit
+      GameTime timeDropped; //!< Game time dropped by the catch-up limit
+      uint64_t posted; //!< Deferred work posted
+      uint64_t executed; //!< Deferred work executed
+      uint64_t forced; //!< Deferred work executed over budget
+      uint64_t rejected; //!< Deferred work dropped on a full queue
+      uint64_t carried; //!< Frames that left deferred work pending
+    };
+    Engine* mEngine;
+    LARGE_INTEGER mFrequency; //!< HPC frequency
+    LARGE_INTEGER mFrameStart; //!< HPC time at frame start
+    std::deque<DeferredWork> mDeferred; //!< Deferred work queue
+    Platform::RWLock mLock; //!< Deferred work queue lock
+    Statistics mStats;
+  public:
+    FrameGovernor( Engine* engine );
+    //! Marks the beginning of a frame.
+    void beginFrame();
+    //! Gets the CPU time spent on the current frame so far, in seconds.
+    GameTime getFrameTime();
+    //! Query whether the current frame has used up its budget.
+    bool isOverBudget();
+    //! Drops accumulated time exceeding the catch-up step limit.
+    //! \param  accumulator The frame time accumulator.
+    //! \param  step        The logic step length.
+    //! \return The accumulator to continue stepping with.
+    GameTime limitCatchUp( GameTime accumulator, GameTime step );
+    //! Posts low-priority work to run when a frame has slack.
+    //! Safe from any thread.
+    //! \return false if the queue was full and the work was dropped.
+    bool post( DeferredFunction function, void* context );
+    //! Runs deferred work until the frame budget is spent. Work that has
+    //! waited too long is run regardless of budget.
+    void drainDeferred();
+    //! Console callback.
+    static void callbackStats( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  ENGINE_EXTERN_CONVAR( stat_window );
+  ENGINE_EXTERN_CONVAR( stat_hitchms );
+  ENGINE_EXTERN_CONCMD( stat_frames );
+  ENGINE_EXTERN_CONCMD( stat_export );
+
+  class Engine;
+
+  const size_t cFrameHistorySize = 2048; //!< Frame & step samples kept, power of two
+  const size_t cMaxHitchReports = 32; //!< Hitch reports kept
+
+  //! Main loop sections timed per frame.
+  enum FrameSection {
+    FrameSection_PreUpdate = 0, //!< Console & graphics pre-update
+    FrameSection_Physics, //!< Physics simulation start & sync
+    FrameSection_Input, //!< Input devices
+    FrameSection_Game, //!< Game state
+    FrameSection_AI, //!< Entity prethink
+    FrameSection_Audio, //!< Sound engine
+    FrameSection_Entities, //!< Entity think
+    FrameSection_Deferred, //!< Deferred work
+    FrameSection_PostUpdate, //!< Game draw & entity visualize
+    FrameSection_Render, //!< Graphics post-update
+    FrameSection_Count
+  };
+
+  //! \class FrameStatistics
+  //! Rolling frame & logic step time history with percentile reports and
+  //! hitch detection. Sections are timed lap-style: each lap() attributes
+  //! the time since the previous lap to the given section.
+  class FrameStatistics: boost::noncopyable {
+  public:
+    struct Percentiles {
+      size_t samples;
+      float p50;
+      float p95;
+      float p99;
+      float max;
+    };
+  protected:
+    struct FrameRecord {
+      float frame; //!< Frame time in ms
+      float sections[FrameSection_Count]; //!< Section times in ms
+      uint32_t steps; //!< Logic steps run
+    };
+    struct HitchReport {
+      uint64_t frame; //!< Frame number
+      GameTime time; //!< Game time
+      float duration; //!< Frame time in ms
+      FrameSection worst; //!< Longest running section
+      float worstDuration; //!< Longest section's time in ms
+    };
+    Engine* mEngine;
+    LARGE_INTEGER mFrequency;
+    LARGE_INTEGER mFrameStart;
+    LARGE_INTEGER mLapStart;
+    LARGE_INTEGER mStepStart;
+    FrameRecord mCurrent; //!< Frame being recorded
+    FrameRecord mFrames[cFrameHistorySize];
+    float mSteps[cFrameHistorySize]; //!< Logic step times in ms
+    uint64_t mFrameCount;
+    uint64_t mStepCount;
+    HitchReport mHitches[cMaxHitchReports];
+    uint64_t mHitchCount;
+    float elapsed( LARGE_INTEGER& since, const LARGE_INTEGER& now );
+    static Percentiles calculate( vector<float>& samples );
+  public:
+    FrameStatistics( Engine* engine );
+    //! Marks the beginning of a frame.
+    void beginFrame();
+    //! Attributes the time since the previous lap to a section.
+    void lap( FrameSection section );
+    //! Marks the beginning of a logic step.
+    void beginStep();
+    //! Marks the end of a logic step and records its duration.
+    void endStep();
+    //! Records the frame and checks it for a hitch.
+    //! \param  time The game time at frame end.
+    void endFrame( GameTime time );
+    //! Percentiles of frame times over the last stat_window frames.
+    Percentiles getFramePercentiles();
+    //! Percentiles of logic step times over the last stat_window steps.
+    Percentiles getStepPercentiles();
+    //! Writes the frame history to a CSV file.
+    bool exportCSV( const wstring& filename );
+    //! Console callbacks.
+    static void callbackFrames( Console* console,
+      ConCmd* command, StringVector& arguments );
+    static void callbackExport( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
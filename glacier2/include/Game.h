@@ -2,12 +2,15 @@
 #include "Types.h"
 #include "State.h"
 #include "EngineComponent.h"
+#include "Console.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
 
 namespace Glacier {
 
+  ENGINE_EXTERN_CONVAR( g_tickrate );
+
   //! \addtogroup Glacier
   //! @{
 
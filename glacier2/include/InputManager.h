@@ -1,6 +1,7 @@
 #pragma once
 #include "Types.h"
 #include "EngineComponent.h"
+#include "Console.h"
 #include "Controllers.h"
 
 // Glacier² Game Engine © 2014 noorus
@@ -8,6 +9,8 @@
 
 namespace Glacier {
 
+  ENGINE_EXTERN_CONVAR( in_tickrate );
+
   //! \addtogroup Glacier
   //! @{
 
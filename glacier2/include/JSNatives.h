@@ -1,6 +1,7 @@
 #pragma once
 #include <v8.h>
 #include "JSObjectWrapper.h"
+#include "Entity.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -53,14 +54,21 @@ namespace Glacier {
       static void shutdown();
     };
 
+    //! \class Entity
+    //! A JavaScript-wrapped entity. Holds a handle rather than a pointer,
+    //! so script references outliving the entity are detected.
     class Entity: public ObjectWrapper<Entity> {
     protected:
-      Glacier::Entity* mEntity;
-      explicit Entity( Glacier::Entity* entity );
+      EntityHandle mHandle;
+      Entity();
       static void jsToString( const FunctionCallbackInfo<v8::Value>& args );
       static void jsGetName( const FunctionCallbackInfo<v8::Value>& args );
+      static void jsIsValid( const FunctionCallbackInfo<v8::Value>& args );
     public:
       ~Entity();
+      void setHandle( const EntityHandle handle );
+      //! Resolves the wrapped entity.
+      //! \return The entity, or null if it has been removed.
       Glacier::Entity* getEntity();
       static Entity* create( Glacier::Entity* entity, Handle<v8::Context> context );
     };
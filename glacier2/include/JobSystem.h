@@ -0,0 +1,164 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+#include "ThreadController.h"
+#include <atomic>
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  ENGINE_EXTERN_CONVAR( job_workers );
+  ENGINE_EXTERN_CONCMD( job_stats );
+
+  class Engine;
+  class JobSystem;
+  struct Job;
+
+  //! Job entry point. The data pointer points at the job's inline payload.
+  typedef void ( *JobFunction )( Job* job, const void* data );
+
+  //! Parallel-for body. Processes elements in the range [begin, end).
+  typedef void ( *JobRangeFunction )( size_t begin, size_t end, void* context );
+
+  const size_t cJobPayloadSize = 64; //!< Bytes of inline payload per job
+  const size_t cMaxJobContinuations = 4; //!< Continuations per job
+  const size_t cMaxJobsPerThread = 4096; //!< Job ring & deque size, power of two
+  const size_t cMaxParallelForBatches = cMaxJobsPerThread / 4; //!< Batches per parallelFor
+
+  //! \struct Job
+  //! A unit of work. Jobs finish when their function has run and all of their
+  //! children have finished; a finished job then schedules its continuations.
+  __declspec( align( 64 ) ) struct Job {
+    JobFunction function; //!< Entry point, may be null for grouping jobs
+    Job* parent; //!< Parent job waiting for us, if any
+    std::atomic<long> unfinished; //!< Self plus unfinished children
+    std::atomic<long> continuationCount; //!< Number of continuations
+    Job* continuations[cMaxJobContinuations]; //!< Jobs to run after us
+    uint8_t payload[cJobPayloadSize]; //!< Inline user data
+  };
+
+  //! \class JobQueue
+  //! Fixed-size Chase-Lev work-stealing deque.
+  //! The owning thread pushes & pops at the bottom, thieves steal from the top.
+  class JobQueue: boost::noncopyable {
+  protected:
+    std::atomic<int64_t> mTop;
+    std::atomic<int64_t> mBottom;
+    Job* mJobs[cMaxJobsPerThread];
+  public:
+    JobQueue();
+    //! Pushes a job. Owner thread only.
+    //! \warning Throws if the deque is full.
+    void push( Job* job );
+    //! Pops the most recently pushed job. Owner thread only.
+    Job* pop();
+    //! Steals the oldest job. Safe from any thread.
+    Job* steal();
+    //! Approximate number of queued jobs.
+    size_t size() const;
+  };
+
+  //! \class JobWorker
+  //! A worker thread executing & stealing jobs.
+  class JobWorker: public ThreadController {
+  protected:
+    JobSystem* mSystem;
+    uint32_t mIndex;
+    virtual void onStart();
+    virtual void onStep();
+    virtual void onPreStop();
+    virtual void onStop();
+  public:
+    JobWorker( JobSystem* system, uint32_t index );
+    HANDLE getThread() { return mThread; }
+    virtual ~JobWorker();
+  };
+
+  //! \class JobSystem
+  //! Work-stealing job scheduler with one deque per participating thread.
+  //! Thread 0 is the engine main thread, threads 1..n are JobWorkers.
+  //! Jobs may only be created and run from those threads.
+  class JobSystem: boost::noncopyable {
+  friend class JobWorker;
+  protected:
+    struct ThreadData {
+      JobQueue queue; //!< Work-stealing deque
+      Job* pool; //!< Job allocation ring
+      uint32_t allocated; //!< Ring allocation counter
+      std::atomic<uint64_t> executed; //!< Jobs executed by this thread
+      std::atomic<uint64_t> stolen; //!< Jobs stolen by this thread
+      ThreadData();
+      ~ThreadData();
+    };
+    Engine* mEngine;
+    vector<ThreadData*> mThreads; //!< Per-thread data, 0 is main
+    vector<JobWorker*> mWorkers; //!< Worker threads
+    HANDLE mWakeSemaphore; //!< Released when jobs are pushed & workers sleep
+    HANDLE mShutdownEvent; //!< Set to release sleeping workers on shutdown
+    std::atomic<long> mSleeping; //!< Number of sleeping workers
+    Job* mStepJob; //!< Root job of the current logic step
+    ThreadData& getThreadData();
+    Job* getJob();
+    void execute( Job* job );
+    void finish( Job* job );
+    void sleep();
+    static void rangeJob( Job* job, const void* data );
+  public:
+    //! Constructor.
+    //! \param  engine  The engine.
+    //! \param  workers Number of worker threads to create in addition to main.
+    JobSystem( Engine* engine, uint32_t workers );
+    //! Number of threads participating in job execution, including main.
+    size_t getThreadCount() const throw() { return mThreads.size(); }
+    //! Number of worker threads.
+    uint32_t getWorkerCount() const throw() { return (uint32_t)mWorkers.size(); }
+    //! Gets a worker thread.
+    JobWorker* getWorker( uint32_t index ) { return mWorkers[index]; }
+    //! Index of the calling thread, or -1 if it is not a job thread.
+    int getThreadIndex() const throw();
+    //! Creates a job without a parent.
+    //! \warning Throws if the calling thread's ring has no finished slot left.
+    Job* createJob( JobFunction function, const void* data = nullptr, size_t size = 0 );
+    //! Creates a job as a child of the given parent.
+    Job* createChild( Job* parent, JobFunction function, const void* data = nullptr, size_t size = 0 );
+    //! Schedules a continuation to run once ancestor has finished.
+    //! \warning Must be called before the ancestor is run.
+    void addContinuation( Job* ancestor, Job* continuation );
+    //! Pushes a job to the calling thread's queue.
+    void run( Job* job );
+    //! Blocks until job has finished, executing other jobs meanwhile.
+    void wait( const Job* job );
+    //! Query whether a job has finished.
+    bool isFinished( const Job* job ) const throw();
+    //! Splits [0, count) into batches of up to batchSize elements as child jobs
+    //! of a new grouping job under parent. The group is run and returned.
+    //! Batches are enlarged as needed to stay within cMaxParallelForBatches.
+    Job* parallelFor( Job* parent, size_t count, size_t batchSize,
+      JobRangeFunction function, void* context );
+    //! Starts a new logic step root job.
+    void beginStep();
+    //! Gets the current logic step's root job, parent step work to this.
+    Job* getStepJob() throw() { return mStepJob; }
+    //! Runs the step root and waits for the whole step job graph to finish.
+    void endStep();
+    //! Console callback.
+    static void callbackStats( Console* console,
+      ConCmd* command, StringVector& arguments );
+    //! Destructor.
+    ~JobSystem();
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
@@ -13,6 +13,7 @@ namespace Glacier {
     glacier_nedalloc::nedpool* mAudioPool;
     glacier_nedalloc::nedpool* mPhysicsPool;
     glacier_nedalloc::nedpool* mNavigationPool;
+    glacier_nedalloc::nedpool* mEntityPool;
     inline glacier_nedalloc::nedpool* resolvePool( const Sector sector )
     {
       if ( sector == Sector_Audio )
@@ -21,6 +22,8 @@ namespace Glacier {
         return mPhysicsPool;
       if ( sector == Sector_Navigation )
         return mNavigationPool;
+      if ( sector == Sector_Entities )
+        return mEntityPool;
       return mGenericPool;
     }
   public:
@@ -10,8 +10,12 @@ namespace Glacier {
 
   ENGINE_EXTERN_CONVAR( px_threads );
   ENGINE_EXTERN_CONVAR( px_cuda );
+  ENGINE_EXTERN_CONVAR( px_pipelined );
+  ENGINE_EXTERN_CONVAR( px_substeps );
+  ENGINE_EXTERN_CONCMD( px_stats );
 
   class PhysicsScene;
+  class CookedMeshCache;
 
   class PhysXPhysics: public EngineComponent, public physx::PxErrorCallback {
   protected:
@@ -24,8 +28,11 @@ namespace Glacier {
     physx::PxFoundation* mFoundation;
     physx::PxPhysics* mPhysics;
     physx::PxCooking* mCooking;
+    CookedMeshCache* mMeshCache;
+    physx::PxSerializationRegistry* mSerialization;
     physx::PxDefaultCpuDispatcher* mCPUDispatcher;
     std::list<PhysicsScene*> mScenes;
+    bool mSimulating; //!< Scenes are simulating and awaiting sync
     virtual void reportError( physx::PxErrorCode::Enum code,
       const char* message, const char* file, int line );
   public:
@@ -35,12 +42,29 @@ namespace Glacier {
     void restart();
     physx::PxPhysics* getPhysics();
     PhysicsScene* createScene();
+    physx::PxSerializationRegistry* getSerialization() { return mSerialization; }
     physx::PxCooking* getCooking();
+    //! Gets the cooked collision mesh cache. Use it instead of the cooker.
+    CookedMeshCache* getMeshCache() { return mMeshCache; }
     void destroyScene( PhysicsScene* scene );
+    //! Starts simulating a step on all scenes.
+    void simulationBegin( GameTime tick, GameTime time );
+    //! Advances the running simulation without blocking, fetching finished
+    //! substeps and starting the next ones. Call between other work.
+    //! \return true if all scenes have finished the step.
+    bool simulationPoll();
+    //! Waits for the running simulation to finish and fetches its results.
+    //! Does nothing if no simulation is running.
+    void simulationSync();
+    //! Query whether a simulation is running, i.e. the scenes are read-only.
+    const bool isSimulating() const throw() { return mSimulating; }
     virtual void componentPreUpdate( GameTime time );
     virtual void componentTick( GameTime tick, GameTime time );
     virtual void componentPostUpdate( GameTime delta, GameTime time );
     virtual ~PhysXPhysics();
+    //! Console callback.
+    static void callbackStats( Console* console,
+      ConCmd* command, StringVector& arguments );
   };
 
 }
\ No newline at end of file
@@ -8,8 +8,61 @@
 
 namespace Glacier {
 
+  ENGINE_EXTERN_CONCMD( px_export );
+
+  const uint32_t cMaxPhysicsSubsteps = 8; //!< Substeps per logic step at most
+
+  //! \struct SimulationTimings
+  //! Wall clock timings of a logic step's simulation.
+  struct SimulationTimings {
+    uint32_t substeps; //!< Substeps simulated
+    float substep[cMaxPhysicsSubsteps]; //!< From simulate until results were fetched, in ms
+    float blocked; //!< Time spent blocking on results, in ms
+  };
+
   class PhysXPhysics;
   class PhysicsDebugVisualizer;
+  class SceneQueries;
+
+  //! \class SubstepCompletionTask
+  //! Signals an event once a scene's simulation is ready to be fetched.
+  //! The scene may report its results fetched before the dispatcher has
+  //! run & released the task, so it must be waited on before being rearmed
+  //! or destroyed.
+  class SubstepCompletionTask: public physx::PxLightCpuTask {
+  protected:
+    HANDLE mEvent;
+    std::atomic<bool> mDone; //!< Released by the dispatcher, or never armed
+  public:
+    SubstepCompletionTask(): mEvent( NULL ), mDone( true ) {}
+    void setEvent( HANDLE event ) { mEvent = event; }
+    //! Marks the task as in use by the dispatcher, before submitting it.
+    void arm() { mDone.store( false, std::memory_order_relaxed ); }
+    //! Waits until the dispatcher is done with the task.
+    void wait() const
+    {
+      while ( !mDone.load( std::memory_order_acquire ) )
+        YieldProcessor();
+    }
+    virtual void run() { SetEvent( mEvent ); }
+    virtual void release()
+    {
+      PxLightCpuTask::release();
+      mDone.store( true, std::memory_order_release );
+    }
+    virtual const char* getName() const { return "SubstepCompletion"; }
+  };
+
+  //! \struct ImportedCollection
+  //! Objects deserialized in place from a binary collection file. The file
+  //! is mapped copy-on-write, so only pages PhysX patches are made private,
+  //! and the view must outlive the objects.
+  struct ImportedCollection {
+    physx::PxCollection* collection;
+    HANDLE file;
+    HANDLE mapping;
+    void* view;
+  };
 
   class PhysicsScene {
   friend class PhysXPhysics;
@@ -21,13 +74,32 @@ namespace Glacier {
     physx::PxCpuDispatcher* mCPUDispatcher;
     physx::PxGpuDispatcher* mGPUDispatcher;
     physx::PxSimulationStatistics mStatistics;
+    uint32_t mSubsteps; //!< Substeps in the current step
+    uint32_t mSubstep; //!< Substeps started in the current step
+    physx::PxReal mSubstepDelta;
+    bool mRunning; //!< A substep is simulating
+    HANDLE mSubstepEvent; //!< Signaled when the running substep can be fetched
+    SubstepCompletionTask mSubstepTask;
+    LARGE_INTEGER mFrequency;
+    LARGE_INTEGER mSubstepStart;
+    SimulationTimings mCurrent; //!< Timings being recorded
+    SimulationTimings mTimings; //!< Timings of the last completed step
     physx::PxControllerManager* mControllerMgr;
+    SceneQueries* mQueries; //!< Batched queries, run after every fetch
+    vector<physx::PxActiveTransform> mActiveTransforms; //!< Of every substep in order
+    vector<physx::PxActor*> mPendingActors; //!< Actors queued by a batch
+    uint32_t mActorBatchDepth; //!< Nesting depth of actor batches
+    std::list<ImportedCollection*> mImports; //!< Live imported collections
+    physx::PxCollection* createSharedCollection();
     PhysicsScene( PhysXPhysics* physics,
       physx::PxCpuDispatcher* cpuDispatcher, physx::PxGpuDispatcher* gpuDispatcher,
       const float gravity, const float restitution,
       const float staticFriction, const float dynamicFriction );
-    void simulationStep( const GameTime delta, const GameTime time );
+    void simulationStep( const GameTime delta, const GameTime time, const uint32_t substeps );
+    bool simulationPoll();
     void simulationFetchResults();
+    void beginSubstep();
+    bool finishSubstep( const bool block );
     void post();
 #ifndef GLACIER_NO_PHYSICS_DEBUG
     PhysicsDebugVisualizer* mVisualizer;
@@ -38,6 +110,37 @@ namespace Glacier {
   public:
     inline physx::PxScene* getScene() const throw() { return mScene; }
     inline physx::PxControllerManager* getControllerManager() const throw() { return mControllerMgr; }
+    inline SceneQueries* getQueries() const throw() { return mQueries; }
+    inline HANDLE getSubstepEvent() const throw() { return mSubstepEvent; }
+    inline const physx::PxSimulationStatistics& getStatistics() const throw() { return mStatistics; }
+    inline const SimulationTimings& getTimings() const throw() { return mTimings; }
+    //! Active transforms of all substeps of the last step, in substep order,
+    //! so a body moved by several substeps appears once per substep.
+    inline const vector<physx::PxActiveTransform>& getActiveTransforms() const throw() { return mActiveTransforms; }
+    //! Adds an actor to the scene, or queues it if a batch is open.
+    void addActor( physx::PxActor& actor );
+    //! Opens an actor batch. Batches nest, and the outermost one adds all
+    //! queued actors to the scene with a single call when it ends.
+    void beginActorBatch();
+    //! Closes an actor batch.
+    void endActorBatch();
+    //! Writes the scene's actors of the given types to a binary collection
+    //! file. The default material is referenced rather than written, and
+    //! resolves to the importing scene's default material.
+    //! \param  filename The file to write, replaced only once complete.
+    //! \param  types    Actor types to write.
+    //! \param  source   Hash of whatever the actors were built from.
+    bool exportCollection( const wstring& filename,
+      physx::PxActorTypeFlags types, uint64_t source = 0 );
+    //! Maps a binary collection file and adds all of its actors to the scene
+    //! with a single insertion.
+    //! \param  filename The file to map.
+    //! \param  source   Hash the file must have been exported with.
+    //! \return The collection, or null on failure or if the file is stale.
+    ImportedCollection* importCollection( const wstring& filename,
+      uint64_t source = 0 );
+    //! Removes & releases an imported collection's objects and unmaps it.
+    void releaseCollection( ImportedCollection* imported );
     float setGravity( const float gravity );
     physx::PxMaterial* getDefaultMaterial() const { return mDefaultMaterial; }
     const float getGravity() const throw() { return -mGravity.y; }
@@ -50,6 +153,9 @@ namespace Glacier {
     void setDebugVisuals( const bool visuals );
     const physx::PxRenderBuffer& fetchDebugVisuals();
 #endif
+    //! Console callback.
+    static void callbackExport( Console* console,
+      ConCmd* command, StringVector& arguments );
   };
 
 }
\ No newline at end of file
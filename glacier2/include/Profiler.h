@@ -0,0 +1,127 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+#include <atomic>
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  ENGINE_EXTERN_CONVAR( prof_enabled );
+  ENGINE_EXTERN_CONCMD( prof_dump );
+
+  const size_t cProfilerRingSize = 65536; //!< Events per thread ring, power of two
+
+  //! \struct ProfileEvent
+  //! A completed profiling scope.
+  struct ProfileEvent {
+    const char* name; //!< Static scope name
+    int64_t start; //!< HPC time at scope entry
+    int64_t end; //!< HPC time at scope exit
+  };
+
+  //! \class ProfilerRing
+  //! Per-thread event ring. Written only by its owning thread without locking,
+  //! older events are overwritten once the ring is full.
+  class ProfilerRing: boost::noncopyable {
+  friend class Profiler;
+  protected:
+    DWORD mThreadID;
+    std::atomic<uint64_t> mHead; //!< Total events written
+    ProfileEvent mEvents[cProfilerRingSize];
+  public:
+    ProfilerRing( DWORD threadID );
+    inline void push( const char* name, int64_t start, int64_t end )
+    {
+      uint64_t head = mHead.load( std::memory_order_relaxed );
+      auto& evt = mEvents[head & ( cProfilerRingSize - 1 )];
+      evt.name = name;
+      evt.start = start;
+      evt.end = end;
+      mHead.store( head + 1, std::memory_order_release );
+    }
+  };
+
+  //! \class Profiler
+  //! Hierarchical CPU profiler with Chrome trace export.
+  //! Scopes nest by time, so no explicit parent tracking is needed.
+  class Profiler {
+  protected:
+    static vector<ProfilerRing*> fRings; //!< Rings of all live threads
+    static std::map<DWORD, string> fThreadNames; //!< Thread names for export
+    static Platform::RWLock fRingsLock; //!< Ring registration lock
+    static LARGE_INTEGER fFrequency; //!< HPC frequency
+    static ProfilerRing* createRing();
+  public:
+    static volatile bool fEnabled; //!< Mirrors prof_enabled for cheap checks
+    //! Gets the calling thread's ring, creating it if necessary.
+    static ProfilerRing* getRing();
+    //! Names the calling thread in exported traces.
+    static void setThreadName( const string& name );
+    //! Writes all recorded events to a Chrome trace JSON file.
+    static bool dump( const wstring& filename );
+    //! Frees the calling thread's ring, dropping its events.
+    //! Call before a thread exits.
+    static void releaseThread();
+    //! Frees all rings. Call only when no other threads are profiling.
+    static void shutdown();
+    //! CVar & console callbacks.
+    static bool callbackEnabled( ConVar* variable, ConVar::Value oldValue );
+    static void callbackDump( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! \class ProfileScope
+  //! Records the lifetime of a scope to the calling thread's ring.
+  class ProfileScope: boost::noncopyable {
+  protected:
+    const char* mName;
+    int64_t mStart;
+  public:
+    inline ProfileScope( const char* name ): mName( name ), mStart( 0 )
+    {
+      if ( !Profiler::fEnabled )
+        return;
+      LARGE_INTEGER now;
+      QueryPerformanceCounter( &now );
+      mStart = now.QuadPart;
+    }
+    inline ~ProfileScope()
+    {
+      if ( !mStart )
+        return;
+      LARGE_INTEGER now;
+      QueryPerformanceCounter( &now );
+      Profiler::getRing()->push( mName, mStart, now.QuadPart );
+    }
+  };
+
+  //! \def GLACIER_PROFILE(name)
+  //! Profiles the enclosing scope under a static name.
+  //! \def GLACIER_PROFILE_FUNCTION()
+  //! Profiles the enclosing function.
+#ifndef GLACIER_NO_PROFILER
+# define GLACIER_PROFILE_CONCAT2(a,b) a##b
+# define GLACIER_PROFILE_CONCAT(a,b) GLACIER_PROFILE_CONCAT2(a,b)
+# define GLACIER_PROFILE(name)\
+  Glacier::ProfileScope GLACIER_PROFILE_CONCAT( profileScope_, __LINE__ )( name )
+# define GLACIER_PROFILE_FUNCTION()\
+  GLACIER_PROFILE( __FUNCTION__ )
+#else
+# define GLACIER_PROFILE(name)
+# define GLACIER_PROFILE_FUNCTION()
+#endif
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
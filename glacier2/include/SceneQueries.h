@@ -0,0 +1,109 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+#include <atomic>
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Physics
+  //! @{
+
+  ENGINE_EXTERN_CONCMD( px_queries );
+
+  //! Ticket for a queued scene query. Packs the batch serial in the high
+  //! word and the request index in the low word, zero is never valid.
+  typedef uint64_t SceneQueryTicket;
+
+  const SceneQueryTicket cInvalidSceneQuery = 0;
+  const uint32_t cMaxSceneQueries = 4096; //!< Requests per batch
+  const uint32_t cSceneQueryHistory = 16; //!< Batches kept readable, power of two
+
+  //! \struct SceneQueryResult
+  //! Closest blocking hit of a ray or sweep.
+  struct SceneQueryResult {
+    bool hit;
+    Vector3 position; //!< Hit position, or sweep's contact point
+    Vector3 normal;
+    Real distance; //!< Distance along the query direction
+    physx::PxRigidActor* actor; //!< Hit actor, valid until actors are next removed
+  };
+
+  //! \class SceneQueries
+  //! Batched ray & sweep queries against a physics scene.
+  //! Requests may be queued from any thread at any time, even while the
+  //! scene is simulating. They are run as one PxBatchQuery right after the
+  //! simulation results have been fetched, and their results stay readable
+  //! by ticket for cSceneQueryHistory batches, so callers ticking slower
+  //! than the logic step can still collect them. Queries made from think
+  //! or postthink are thus answered on the next logic step.
+  class SceneQueries: boost::noncopyable {
+  protected:
+    enum RequestType {
+      Request_Raycast,
+      Request_SweepSphere
+    };
+    struct Request {
+      RequestType type;
+      physx::PxVec3 origin;
+      physx::PxVec3 direction; //!< Normalized
+      physx::PxReal distance;
+      physx::PxReal radius; //!< Sweep sphere radius
+    };
+    struct ResultBatch {
+      uint32_t serial; //!< Serial of the batch, zero if none
+      vector<SceneQueryResult> results;
+    };
+    struct Stats {
+      uint32_t raycasts; //!< Raycasts in the last batch
+      uint32_t sweeps; //!< Sweeps in the last batch
+      uint32_t dropped; //!< Requests dropped from the last batch
+      uint64_t batches; //!< Batches run
+      uint64_t queries; //!< Total queries run
+      float duration; //!< Last batch run time in ms
+    };
+    physx::PxScene* mScene;
+    physx::PxBatchQuery* mBatch;
+    Request mRequests[cMaxSceneQueries]; //!< Requests for the next batch
+    std::atomic<uint32_t> mRequestCount; //!< May exceed the capacity on overflow
+    uint32_t mSerial; //!< Serial of the batch being collected
+    ResultBatch mHistory[cSceneQueryHistory]; //!< Results of recent batches by serial
+    vector<physx::PxRaycastQueryResult> mRaycastResults;
+    vector<physx::PxSweepQueryResult> mSweepResults;
+    LARGE_INTEGER mFrequency;
+    Stats mStats;
+    SceneQueryTicket enqueue( const Request& request );
+  public:
+    SceneQueries( physx::PxScene* scene );
+    //! Queues a ray query for the closest static or dynamic hit.
+    SceneQueryTicket raycast( const Vector3& origin,
+      const Vector3& direction, const Real distance );
+    //! Queues a sphere sweep query for the closest static or dynamic hit.
+    SceneQueryTicket sweepSphere( const Vector3& origin, const Real radius,
+      const Vector3& direction, const Real distance );
+    //! Whether the ticket is still waiting for its batch to run.
+    const bool isPending( const SceneQueryTicket ticket ) const throw();
+    //! Gets the result for a ticket from one of the recent batches.
+    //! \return false if the ticket is pending, expired or was dropped.
+    const bool getResult( const SceneQueryTicket ticket,
+      SceneQueryResult& result ) const throw();
+    //! Runs all queued requests. Call only while the scene is not simulating
+    //! and no thread is queueing requests.
+    void execute();
+    ~SceneQueries();
+    //! Console callbacks.
+    static void callbackStats( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
@@ -50,6 +50,8 @@ namespace Glacier {
       physicsService = physics;
     }
 
+    static const bool hasGraphics() { return ( graphicsService ? true : false ); }
+
     static Graphics& getGraphics() { return *graphicsService; }
 
     static void provideGraphics( Graphics* graphics )
@@ -43,7 +43,8 @@ namespace Glacier {
       Sector_Generic,
       Sector_Audio,
       Sector_Physics,
-      Sector_Navigation
+      Sector_Navigation,
+      Sector_Entities
     };
     virtual void* alloc( const Sector sector, size_t size, size_t alignment = 0Ui64 ) = 0;
     virtual void* realloc( const Sector sector, void* location, size_t size, size_t alignment = 0Ui64 ) = 0;
@@ -1,27 +1,80 @@
 #pragma once
 #include "Exception.h"
+#include "Utilities.h"
+#include "Console.h"
+#include <atomic>
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
 
 namespace Glacier {
 
+  ENGINE_EXTERN_CONCMD( threads );
+
+  //! \class ThreadController
+  //! Base for engine background threads.
+  //! Continuous threads call onStep() back to back and must block in it on
+  //! their own. Wake-driven threads sleep until stopped, woken through
+  //! wake(), signaled by an added wake source or fired by their periodic
+  //! timer, and step once per wakeup, so they cost nothing while idle.
   class ThreadController: boost::noncopyable {
+  public:
+    //! Step scheduling mode.
+    enum StepMode {
+      Step_Continuous, //!< Step back to back until stopped
+      Step_OnWake //!< Step once per wakeup
+    };
   protected:
+    string mName; //!< Thread name for debuggers & profiles
+    StepMode mMode;
     HANDLE mThread;
     DWORD mThreadID;
     volatile HANDLE mRunEvent;
     volatile HANDLE mStopEvent;
+    HANDLE mWakeEvent; //!< Signaled by wake()
+    HANDLE mTimer; //!< Periodic step timer, if any
+    DWORD mPeriod; //!< Periodic step interval in milliseconds, 0 for none
+    vector<HANDLE> mWakeSources; //!< Extra handles that wake the thread
+    vector<HANDLE> mWaitHandles; //!< Stop event followed by all wake sources
+    std::atomic<uint64_t> mSteps; //!< Steps run
+    std::atomic<uint64_t> mWakeups; //!< Wakeups by source
+    ULONGLONG mStartTick; //!< Tick count at start
+    ULONGLONG mStopTick; //!< Tick count at stop
+    ULONGLONG mUserTime; //!< User CPU time of the last run, in 100ns
+    ULONGLONG mKernelTime; //!< Kernel CPU time of the last run, in 100ns
+    static vector<ThreadController*> fControllers; //!< Live controllers
+    static Platform::RWLock fControllersLock;
     virtual void onStart() = 0;
     virtual void onStep() = 0;
     virtual void onPreStop() = 0;
     virtual void onStop() = 0;
+    void captureTimes();
     static DWORD WINAPI threadProc( void* argument );
   public:
-    ThreadController();
+    //! Constructor.
+    //! \param  name (Optional) Thread name.
+    //! \param  mode (Optional) Step scheduling mode.
+    ThreadController( const string& name = "", StepMode mode = Step_Continuous );
+    //! Steps a wake-driven thread every given milliseconds, 0 to disable.
+    //! Takes effect on next start.
+    void setPeriod( DWORD milliseconds );
+    //! Adds a handle whose signaled state wakes the thread.
+    //! Takes effect on next start.
+    void addWakeSource( HANDLE handle );
+    //! Wakes the thread for a step. Safe from any thread.
+    void wake();
+    const string& getName() { return mName; }
+    DWORD getThreadID() { return mThreadID; }
+    //! Gets the CPU time used by the thread's current or last run.
+    //! \param  user   Receives user mode time in seconds.
+    //! \param  kernel Receives kernel mode time in seconds.
+    void getCPUTime( GameTime& user, GameTime& kernel );
     virtual void start();
     virtual void stop();
     virtual ~ThreadController();
+    //! Console callback.
+    static void callbackThreads( Console* console,
+      ConCmd* command, StringVector& arguments );
   };
 
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Console.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  ENGINE_EXTERN_CONVAR( eng_threadpolicy );
+  ENGINE_EXTERN_CONCMD( thread_layout );
+
+  class Engine;
+
+  //! \class ThreadPlacement
+  //! Assigns engine threads to physical cores based on the CPU topology.
+  //! The main thread keeps the first core in the process mask; physics
+  //! dispatch threads and job workers get physical cores of their own, with
+  //! all SMT siblings, for as long as there are enough, then wrap around.
+  //! I/O threads float over every core except the main thread's.
+  class ThreadPlacement: boost::noncopyable {
+  public:
+    //! Placement policies, set by eng_threadpolicy.
+    enum Policy {
+      Policy_None = 0, //!< Leave all placement to the OS
+      Policy_Main, //!< Only pin the main thread to its first logical core
+      Policy_Spread, //!< Alternate cores between L3 groups
+      Policy_Compact, //!< Fill the main thread's L3 group first
+      Policy_Count
+    };
+    //! Thread roles.
+    enum Role {
+      Role_Main = 0, //!< Engine main thread
+      Role_Physics, //!< Physics dispatch threads
+      Role_Worker, //!< Job workers
+      Role_IO, //!< Console window & other mostly idle threads
+      Role_Count
+    };
+  protected:
+    struct Core {
+      DWORD_PTR mask; //!< Logical processors in the process mask
+      uint32_t cache; //!< L3 group index
+    };
+    struct Assignment {
+      wstring name;
+      Role role;
+      DWORD threadID; //!< Zero if not known
+      DWORD_PTR mask; //!< Zero if left to the OS
+    };
+    Engine* mEngine;
+    Policy mPolicy;
+    vector<Core> mCores; //!< Physical cores available to the process
+    uint32_t mCacheGroups; //!< Number of L3 groups
+    uint32_t mLogicalCount; //!< Logical processors available to the process
+    DWORD_PTR mMainMask; //!< Main thread's core
+    vector<DWORD_PTR> mOrder; //!< Other cores in assignment order
+    uint32_t mPhysicsThreads; //!< Cores reserved for physics dispatch
+    vector<Assignment> mLayout;
+    Platform::RWLock mLock;
+    void readTopology();
+    void plan();
+  public:
+    //! Constructor.
+    //! \param  engine         The engine.
+    //! \param  physicsThreads Number of physics dispatch threads.
+    ThreadPlacement( Engine* engine, uint32_t physicsThreads );
+    //! Gets the affinity mask for a thread role.
+    //! \param  role  The role.
+    //! \param  index Index of the thread within its role.
+    //! \return The mask, or zero to leave the thread to the OS.
+    DWORD_PTR getMask( Role role, uint32_t index );
+    //! Applies the role's affinity to a thread and records it in the layout.
+    void place( HANDLE thread, DWORD threadID, Role role, uint32_t index,
+      const wstring& name );
+    //! Gets the number of physical cores available to the process.
+    uint32_t getCoreCount() const throw() { return (uint32_t)mCores.size(); }
+    //! Gets the number of cores reserved for physics dispatch.
+    uint32_t getPhysicsThreads() const throw() { return mPhysicsThreads; }
+    //! Console callback.
+    static void callbackLayout( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include "Types.h"
+#include "Console.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \addtogroup Glacier
+  //! @{
+
+  //! \addtogroup Engine
+  //! @{
+
+  ENGINE_EXTERN_CONCMD( sched_info );
+
+  class Engine;
+
+  //! \class TickScheduler
+  //! Runs engine components at their own tick rates.
+  //! Every rate is rounded to an integer divisor of the base logic step, and
+  //! slots with divisors above one are given phases so that low-rate work is
+  //! spread evenly over base steps instead of landing on the same one.
+  class TickScheduler: boost::noncopyable {
+  public:
+    struct Slot {
+      wstring name; //!< Display name
+      ConVar* rate; //!< Rate variable in Hz, null for base rate
+      int rateCache; //!< Rate the divisor was computed from
+      uint32_t divisor; //!< Ticks every divisor base steps
+      uint32_t phase; //!< Base step offset within divisor
+      uint64_t ticks; //!< Ticks run so far
+      Slot(): rate( nullptr ), rateCache( 0 ), divisor( 1 ),
+        phase( 0 ), ticks( 0 ) {}
+    };
+  protected:
+    Engine* mEngine;
+    vector<Slot> mSlots;
+    GameTime mBaseStep; //!< Base logic step length
+    uint64_t mStep; //!< Base step counter
+    bool isDirty();
+  public:
+    TickScheduler( Engine* engine );
+    //! Registers a slot with the given identifier.
+    //! \param  id    Caller-chosen slot index.
+    //! \param  name  Display name.
+    //! \param  rate  Rate variable in Hz, or null to tick on every base step.
+    void addSlot( size_t id, const wstring& name, ConVar* rate );
+    //! Recomputes divisors & phases for a new base step length.
+    void configure( GameTime baseStep );
+    //! Query whether a slot ticks on the current base step.
+    //! \param  id    Slot index.
+    //! \param  tick  [out] Time step for the slot, a multiple of the base step.
+    bool isDue( size_t id, GameTime& tick );
+    //! Moves on to the next base step, reconfiguring if any rate has changed.
+    void advance();
+    //! Console callback.
+    static void callbackInfo( Console* console,
+      ConCmd* command, StringVector& arguments );
+  };
+
+  //! @}
+
+  //! @}
+
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "Types.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! \class TransformStore
+  //! Structure-of-arrays storage for entity transforms, owned by the World.
+  //! Every component of the current & previous step's positions and
+  //! orientations lives in its own contiguous float array. Slots are dense
+  //! & unordered; releasing one moves the last slot into its place and
+  //! updates that owner's index.
+  //! Only slots written during the current or previous logic step are kept
+  //! on a moving list, and storing, interpolating & syncing walk that list
+  //! alone, so transforms at rest cost nothing per frame. Physics poses
+  //! come from the scene's active transforms, i.e. only bodies that are
+  //! awake & moved.
+  class TransformStore: boost::noncopyable {
+  public:
+    //! Per-slot flags.
+    enum Flags: uint8_t {
+      Flag_Dirty = 1, //!< Written during the current logic step
+      Flag_Moved = 2, //!< Written during the previous logic step
+      Flag_SyncPosition = 4, //!< Node follows the position
+      Flag_SyncOrientation = 8 //!< Node follows the orientation
+    };
+  protected:
+    vector<float> mPosition[3]; //!< Current x, y, z
+    vector<float> mPrevPosition[3]; //!< Previous step's x, y, z
+    vector<float> mOrientation[4]; //!< Current w, x, y, z
+    vector<float> mPrevOrientation[4]; //!< Previous step's w, x, y, z
+    vector<uint8_t> mFlags;
+    vector<SceneNode*> mNodes; //!< Synced scene nodes, if any
+    vector<physx::PxRigidActor*> mActors; //!< Physics actors to read back, if any
+    vector<uint32_t*> mOwners; //!< Owners' slot index members
+    vector<uint32_t> mMovingIndex; //!< Index in mMoving, or invalid
+    vector<uint32_t> mMoving; //!< Slots written recently, unordered
+    vector<vector<uint32_t>> mDeferredMoves; //!< Slots first written by each job thread while deferring
+    bool mDeferring; //!< Whether job threads are writing transforms
+    void markDirty( uint32_t slot );
+    void unlist( uint32_t slot );
+  public:
+    TransformStore();
+    //! Allocates a slot at the origin.
+    //! \param  owner Index member to keep updated as slots move.
+    uint32_t allocate( uint32_t* owner );
+    void release( uint32_t slot );
+    //! Preallocates storage for count slots in total.
+    void reserve( size_t count );
+    inline size_t size() const throw() { return mFlags.size(); }
+    //! Number of slots written during the current or previous logic step.
+    inline size_t getMovingCount() const throw() { return mMoving.size(); }
+    const Vector3 getPosition( uint32_t slot ) const;
+    const Quaternion getOrientation( uint32_t slot ) const;
+    void setPosition( uint32_t slot, const Vector3& position );
+    void setOrientation( uint32_t slot, const Quaternion& orientation );
+    const Vector3 getInterpolatedPosition( uint32_t slot, GameTime alpha ) const;
+    const Quaternion getInterpolatedOrientation( uint32_t slot, GameTime alpha ) const;
+    //! Sets the scene node synced from a slot, and which parts to sync.
+    void setNode( uint32_t slot, SceneNode* node, uint8_t syncFlags );
+    //! Sets the physics actor whose pose is read back into a slot.
+    //! The actor's user data is pointed at the slot's owner index.
+    void setActor( uint32_t slot, physx::PxRigidActor* actor );
+    //! Makes a slot's current transform its previous one, e.g. on teleport.
+    void storePrevious( uint32_t slot );
+    //! Makes all moving transforms the previous ones, at logic step start.
+    void storePrevious();
+    //! Starts collecting newly moving slots per job thread, so that job
+    //! threads may write the transforms of their own entities.
+    //! \param  threads Number of job threads.
+    void beginDeferring( size_t threads );
+    //! Lists the slots written since beginDeferring as moving.
+    void endDeferring();
+    //! Reads back the poses of active actors, later entries for the same
+    //! actor overriding earlier ones.
+    //! Physics must not be simulating, and no actors may have been removed
+    //! since results were fetched.
+    void readPhysics( const vector<physx::PxActiveTransform>& transforms );
+    //! Interpolates moving transforms and writes their nodes.
+    void sync( GameTime alpha );
+  };
+
+}
\ No newline at end of file
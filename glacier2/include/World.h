@@ -8,15 +8,18 @@ namespace Glacier {
   class PhysicsScene;
   class EntityManager;
   class Scripting;
+  class TransformStore;
 
   class World {
   protected:
     EntityManager* mEntities;
     PhysicsScene* mPhysics;
+    TransformStore* mTransforms;
   public:
     World( Engine* engine );
     inline EntityManager* getEntities() const throw( ) { return mEntities; }
     inline PhysicsScene* getPhysics() const throw( ) { return mPhysics; }
+    inline TransformStore* getTransforms() const throw( ) { return mTransforms; }
     Scripting* getScripting() const throw( );
     ~World();
   };
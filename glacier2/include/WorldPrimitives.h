@@ -13,6 +13,8 @@ namespace Glacier {
 
   namespace Primitives {
 
+    //! Level geometry. Non-physical primitives are visual only, for when
+    //! the level's actors come from a serialized collection instead.
     class Primitive {
     protected:
       Ogre::Item* mItem;
@@ -29,7 +31,7 @@ namespace Glacier {
     protected:
       Ogre::MeshPtr mMesh;
     public:
-      Plane( PhysicsScene* scene, const Ogre::Plane& plane, const Real width, const Real height, const Vector3& position, const Real u = 1.0f, const Real v = 1.0f );
+      Plane( PhysicsScene* scene, const Ogre::Plane& plane, const Real width, const Real height, const Vector3& position, const Real u = 1.0f, const Real v = 1.0f, const bool physical = true );
       virtual ~Plane();
     };
 
@@ -37,7 +39,7 @@ namespace Glacier {
     protected:
       Ogre::MeshPtr mMesh;
     public:
-      Box( PhysicsScene* scene, const Vector3& size, const Vector3& position, const Quaternion& orientation );
+      Box( PhysicsScene* scene, const Vector3& size, const Vector3& position, const Quaternion& orientation, const bool physical = true );
       virtual ~Box();
     };
 
@@ -0,0 +1,216 @@
+#include "StdAfx.h"
+#include "Benchmarks.h"
+#include "Console.h"
+#include "Exception.h"
+#include "Engine.h"
+#include "World.h"
+#include "EntityManager.h"
+#include "DeveloperEntities.h"
+#include "Character.h"
+#include "PhysicsScene.h"
+#include "SceneQueries.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  const uint64_t cQueueBenchDefaultCount = 1000000;
+  const long cQueueBenchCapacity = 1024;
+  const uint32_t cQueueBenchProducers[] = { 1, 2, 4, 8 };
+  const int cSpawnBenchDefaultCount = 10000;
+  const int cSightCheckDefaultSteps = 30;
+  const Real cSightCheckDistance = 3.0f;
+
+  ENGINE_DECLARE_CONCMD( bench_queue,
+    L"Measure SafeWaitableQueue throughput at 1, 2, 4 and 8 producers. Format: bench_queue [elements]",
+    Benchmarks::callbackQueue );
+  ENGINE_DECLARE_CONCMD( bench_spawn,
+    L"Measure batch spawning of small developer cubes, which are removed on the next step. Format: bench_spawn [count]",
+    Benchmarks::callbackSpawn );
+  ENGINE_DECLARE_CONCMD( ai_sightcheck,
+    L"Check that a dummy facing the player keeps seeing it at the current ai_tickrate & eng_tickrate. Format: ai_sightcheck [steps]",
+    Benchmarks::callbackSightCheck );
+
+  DWORD WINAPI Benchmarks::queueProducerProc( void* argument )
+  {
+    auto producer = (QueueProducer*)argument;
+
+    WaitForSingleObject( producer->start, INFINITE );
+    for ( uint64_t i = 0; i < producer->count; i++ )
+      producer->queue->waitPush( i );
+
+    return 0;
+  }
+
+  double Benchmarks::runQueue( uint32_t producers, uint64_t count,
+  long capacity )
+  {
+    BenchQueue queue( capacity );
+
+    HANDLE start = CreateEventW( NULL, TRUE, FALSE, NULL );
+    if ( !start )
+      ENGINE_EXCEPT_WINAPI( "Failed to create event" );
+
+    vector<QueueProducer> contexts( producers );
+    vector<HANDLE> threads( producers, NULL );
+    for ( uint32_t i = 0; i < producers; i++ )
+    {
+      contexts[i].queue = &queue;
+      contexts[i].count = count / producers + ( i < count % producers ? 1 : 0 );
+      contexts[i].start = start;
+      threads[i] = CreateThread( NULL, NULL, queueProducerProc,
+        &contexts[i], 0, NULL );
+      if ( !threads[i] )
+        ENGINE_EXCEPT_WINAPI( "Failed to create thread" );
+    }
+
+    LARGE_INTEGER frequency, begin, end;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &begin );
+    SetEvent( start );
+
+    uint64_t element;
+    for ( uint64_t i = 0; i < count; i++ )
+      queue.waitPop( element );
+
+    QueryPerformanceCounter( &end );
+
+    WaitForMultipleObjects( producers, threads.data(), TRUE, INFINITE );
+    for ( auto thread : threads )
+      CloseHandle( thread );
+    CloseHandle( start );
+
+    return (double)( end.QuadPart - begin.QuadPart ) / (double)frequency.QuadPart;
+  }
+
+  void Benchmarks::callbackQueue( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    uint64_t count = cQueueBenchDefaultCount;
+    if ( arguments.size() > 1 )
+      count = std::max( _wtoi64( arguments[1].c_str() ), (int64_t)1 );
+
+    console->printf( Console::srcEngine,
+      L"Queue benchmark: %I64u elements, capacity %d, one consumer",
+      count, (int)cQueueBenchCapacity );
+
+    for ( auto producers : cQueueBenchProducers )
+    {
+      auto seconds = runQueue( producers, count, cQueueBenchCapacity );
+      console->printf( Console::srcEngine,
+        L"  %d producers: %.2fms, %.2fM elements/s",
+        producers, seconds * 1000.0, (double)count / seconds / 1000000.0 );
+    }
+  }
+
+  void Benchmarks::callbackSpawn( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getWorld() )
+      return;
+
+    int count = cSpawnBenchDefaultCount;
+    if ( arguments.size() > 1 )
+      count = std::max( _wtoi( arguments[1].c_str() ), 1 );
+
+    // Stack the cubes in a grid high above the origin
+    const Entities::DevCube::Type type = Entities::DevCube::DevCube_025;
+    int side = (int)ceil( sqrt( (double)count ) );
+    EntitySpawnVector spawns;
+    spawns.reserve( count );
+    for ( int i = 0; i < count; i++ )
+    {
+      Vector3 position( (Real)( i % side ) * 0.5f, 50.0f, (Real)( i / side ) * 0.5f );
+      spawns.push_back( EntitySpawn( "dev_cube", position, Quaternion::IDENTITY, &type ) );
+    }
+
+    auto entities = gEngine->getWorld()->getEntities();
+    EntityVector spawned;
+
+    LARGE_INTEGER frequency, begin, end;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &begin );
+    entities->spawnBatch( spawns.data(), spawns.size(), &spawned );
+    QueryPerformanceCounter( &end );
+
+    for ( auto entity : spawned )
+      entities->markForRemoval( entity );
+
+    console->printf( Console::srcEngine,
+      L"Spawned %d cubes in %.2fms",
+      count, (double)( end.QuadPart - begin.QuadPart ) * 1000.0 / (double)frequency.QuadPart );
+  }
+
+  void Benchmarks::callbackSightCheck( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getWorld() || !gEngine->getWorld()->getPhysics() )
+      return;
+
+    auto world = gEngine->getWorld();
+    auto entities = world->getEntities();
+    auto player = entities->findByName( "player" );
+    if ( !player )
+    {
+      console->errorPrintf( Console::srcEngine, L"No player to check against" );
+      return;
+    }
+
+    int steps = cSightCheckDefaultSteps;
+    if ( arguments.size() > 1 )
+      steps = std::max( _wtoi( arguments[1].c_str() ), 1 );
+
+    // AI ticks every divisor logic steps, rounded like the tick scheduler does
+    auto engineRate = std::max( g_CVar_eng_tickrate.getInt(), 1 );
+    auto aiRate = std::max( g_CVar_ai_tickrate.getInt(), 1 );
+    auto divisor = std::max( (int)( (double)engineRate / (double)aiRate + 0.5 ), 1 );
+
+    // Dummies face +Z until they start turning, so stand one behind the player
+    EntitySpawn spawn( "dev_dummy",
+      player->getPosition() - Vector3::UNIT_Z * cSightCheckDistance,
+      Quaternion::IDENTITY );
+    EntityVector spawned;
+    entities->spawnBatch( &spawn, 1, &spawned );
+    if ( spawned.empty() )
+    {
+      console->errorPrintf( Console::srcEngine, L"Failed to spawn a dummy" );
+      return;
+    }
+    auto dummy = (Character*)spawned[0];
+
+    // Probe on the AI's schedule while a query batch runs every logic step;
+    // the first tick only sends out the first probe. Batches run on a
+    // private instance, so the live one keeps its tickets & serial
+    auto queries = new SceneQueries( world->getPhysics()->getScene() );
+    int ticks = 0;
+    int seen = 0;
+    for ( int step = 0; step < steps; step++ )
+    {
+      if ( step % divisor == 0 )
+      {
+        bool visible = dummy->canSee( player, queries );
+        if ( step > 0 )
+        {
+          ticks++;
+          if ( visible )
+            seen++;
+        }
+      }
+      queries->execute();
+    }
+
+    SAFE_DELETE( queries );
+    entities->markForRemoval( dummy );
+
+    if ( ticks > 0 && seen == ticks )
+      console->printf( Console::srcEngine,
+        L"Sight check passed: player seen on all %d AI ticks, %d steps apart",
+        ticks, divisor );
+    else
+      console->errorPrintf( Console::srcEngine,
+        L"Sight check failed: player seen on %d of %d AI ticks, %d steps apart",
+        seen, ticks, divisor );
+  }
+
+}
\ No newline at end of file
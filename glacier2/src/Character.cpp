@@ -13,6 +13,9 @@
 #include "Actions.h"
 #include "InputManager.h"
 #include "Graphics.h"
+#include "Profiler.h"
+#include "TransformStore.h"
+#include "SceneQueries.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -25,16 +28,30 @@ namespace Glacier {
   mInput( input ), mPhysics( nullptr ), mMovement( nullptr )
   {
     mFacing = Vector3::UNIT_Z;
+    mSight.count = 0;
+    mSight.visible = false;
+    // Input only touches our own move data, movement is in postthink
+    mThreadedThink = true;
   }
 
   void Character::spawn( const Vector3& position, const Quaternion& orientation )
   {
     Entity::spawn( position, orientation );
 
+    // Characters face by their own means, the node only follows position
+    if ( mNode )
+      mWorld->getTransforms()->setNode( mTransform, mNode,
+        TransformStore::Flag_SyncPosition );
+
     mPhysics = new CharacterPhysicsComponent( mWorld, position, mHeight, mRadius );
     mMovement = new CharacterMovementComponent( this );
   }
 
+  physx::PxRigidActor* Character::getActor()
+  {
+    return ( mPhysics ? mPhysics->getController()->getActor() : nullptr );
+  }
+
   const Vector3& Character::getLocalEyePosition() const
   {
     return mEyePosition;
@@ -67,70 +84,108 @@ namespace Glacier {
 
   void Character::think( const GameTime delta )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     if ( mInput )
       mInput->update( mActions, delta );
+  }
 
+  void Character::postthink( const GameTime delta )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    // Controller moves aren't thread safe, so movement happens here
     if ( mPhysics && mMovement )
     {
       mMovement->generate( mMove, delta, mPhysics );
       mPhysics->update();
+      setPosition( mPhysics->getPosition() );
     }
   }
 
-  void Character::visualize()
+  const bool Character::canSee( Entity* entity ) const
   {
-    mNode->setPosition( mPhysics->getPosition() );
+    return canSee( entity, mWorld->getPhysics()->getQueries() );
   }
 
-  const bool Character::canSee( Entity* entity ) const
+  const bool Character::canSee( Entity* entity, SceneQueries* queries ) const
   {
-    auto scene = Locator::getGraphics().getScene();
-    auto movable = entity->getMovable();
-    auto worldEye = getWorldEyePosition();
-    auto halfFov = Degree( mFieldOfView.valueDegrees() / 2.0f );
-    auto aabb = movable->getWorldAabbUpdated();
-
-    if ( aabb.distance( worldEye ) > mViewDistance )
-      return false;
+    // We only keep track of one target, a new one starts out unseen
+    if ( mSight.target != entity->getHandle() )
+    {
+      mSight.target = entity->getHandle();
+      mSight.count = 0;
+      mSight.visible = false;
+    }
 
-    auto samplingPoints = Math::aabbCorners( aabb );
-    for ( size_t i = 0; i < samplingPoints.size(); i++ )
+    // Collect the previous probe: the target is seen if any ray reached its
+    // sampling point unobstructed, or was stopped by the target itself.
+    // A probe that expired before we got back to it says nothing, so the
+    // last verdict stands until the new one is answered
+    if ( mSight.count > 0 )
     {
-      auto sample = samplingPoints[i];
-      if ( sample.distance( worldEye ) <= mViewDistance )
+      for ( uint32_t i = 0; i < mSight.count; i++ )
+        if ( queries->isPending( mSight.tickets[i] ) )
+          return mSight.visible;
+
+      auto actor = entity->getActor();
+      bool answered = false;
+      bool visible = false;
+      for ( uint32_t i = 0; i < mSight.count; i++ )
       {
-        sample -= worldEye;
-        if ( sample.angleBetween( mFacing ) <= halfFov )
+        SceneQueryResult result;
+        if ( !queries->getResult( mSight.tickets[i], result ) )
+          continue;
+        answered = true;
+        if ( !result.hit || ( actor && result.actor == actor ) )
         {
-          Ogre::Ray ray( worldEye, sample );
-          auto query = scene->createRayQuery( ray );
-
-          // Mask out cameras, because 1) we don't care 2) their bounds will
-          // be out of date, causing an assertion failure
-          uint32_t mask = 0xFFFFFFFF;
-          mask &= ~SceneQueryFlag_Camera;
-          query->setQueryMask( mask );
-          query->setSortByDistance( true );
-
-          auto results = query->execute();
-          for ( auto result : results )
-          {
-            if ( !result.movable )
-              break;
-            auto flags = result.movable->getQueryFlags();
-            if ( ( flags & SceneQueryFlag_World ) != 0 )
-              break;
-            if ( result.movable->getId() == movable->getId() )
-            {
-              scene->destroyQuery( query );
-              return true;
-            }
-          }
-          scene->destroyQuery( query );
+          visible = true;
+          break;
         }
       }
+      if ( answered )
+        mSight.visible = visible;
+      mSight.count = 0;
     }
-    return false;
+
+    auto worldEye = getWorldEyePosition();
+    auto halfFov = Degree( mFieldOfView.valueDegrees() / 2.0f );
+
+    // Sample the corners of the target's bounds if we have a scene to get
+    // them from, and its position otherwise
+    vector<Vector3> samplingPoints;
+    auto movable = ( Locator::hasGraphics() ? entity->getMovable() : nullptr );
+    if ( movable )
+    {
+      auto aabb = movable->getWorldAabbUpdated();
+      if ( aabb.distance( worldEye ) > mViewDistance )
+        return ( mSight.visible = false );
+      samplingPoints = Math::aabbCorners( aabb );
+    }
+    else
+      samplingPoints.push_back( entity->getPosition() );
+
+    // Rays start outside our own capsule, or it would block them all
+    const Real skip = mRadius * 2.0f;
+    for ( auto& sample : samplingPoints )
+    {
+      auto direction = sample - worldEye;
+      auto distance = direction.length();
+      if ( distance > mViewDistance || direction.angleBetween( mFacing ) > halfFov )
+        continue;
+      if ( distance <= skip )
+        return ( mSight.visible = true );
+      direction /= distance;
+      auto ticket = queries->raycast( worldEye + direction * skip, direction, distance - skip );
+      if ( ticket != cInvalidSceneQuery && mSight.count < cMaxSightRays )
+        mSight.tickets[mSight.count++] = ticket;
+    }
+
+    // Nothing within view distance & field of view
+    if ( mSight.count == 0 )
+      mSight.visible = false;
+
+    return mSight.visible;
   }
 
   void Character::onHitGround()
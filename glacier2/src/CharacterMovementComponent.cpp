@@ -8,6 +8,7 @@
 #include "World.h"
 #include "Entity.h"
 #include "PhysicsScene.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -54,6 +55,8 @@ namespace Glacier {
   void CharacterMovementComponent::generate(
   CharacterMoveData& move, const GameTime delta, CharacterPhysicsComponent* physics )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     // Reset displacement
     mDisplacement = Vector3::ZERO;
 
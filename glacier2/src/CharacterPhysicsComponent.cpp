@@ -8,6 +8,7 @@
 #include "GlacierMath.h"
 #include "Character.h"
 #include "World.h"
+#include "SceneQueries.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -21,7 +22,8 @@ namespace Glacier {
   CharacterPhysicsComponent::CharacterPhysicsComponent(
   World* world, const Vector3& position, const Real height, const Real radius ):
   mPosition( position ), mController( nullptr ), mMaterial( nullptr ),
-  mWorld( world ), mHeight( height ), mRadius( radius )
+  mWorld( world ), mHeight( height ), mRadius( radius ),
+  mGroundTicket( cInvalidSceneQuery )
   {
     mScene = mWorld->getPhysics()->getScene();
 
@@ -66,21 +68,26 @@ namespace Glacier {
 
   CharacterPhysicsComponent::GroundQuery CharacterPhysicsComponent::groundQuery( const Vector3& position )
   {
-    GroundQuery query;
-    PxRaycastHit hit;
+    auto queries = mWorld->getPhysics()->getQueries();
 
-    PxVec3 origin( position.x, position.y + cMaxSlopeDelta, position.z );
-    PxVec3 direction( 0.0f, -1.0f, 0.0f );
+    // A probe whose batch hasn't run yet is left in flight, one that
+    // expired unanswered says nothing about the ground here
+    if ( queries->isPending( mGroundTicket ) )
+      return mGround;
 
-    const PxHitFlags flags = PxHitFlag::eDEFAULT;
-    PxQueryFilterData filter( PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC );
-    if ( mScene->raycastSingle( origin, direction, cMaxSlopeDelta * 2.0f, flags, hit, filter ) )
+    SceneQueryResult result;
+    if ( queries->getResult( mGroundTicket, result ) )
     {
-      query.hit = true;
-      query.position = Math::pxVec3ToOgre( hit.position );
+      mGround.hit = result.hit;
+      mGround.position = result.position;
     }
+    else
+      mGround = GroundQuery();
 
-    return query;
+    Vector3 origin( position.x, position.y + cMaxSlopeDelta, position.z );
+    mGroundTicket = queries->raycast( origin, Vector3::NEGATIVE_UNIT_Y, cMaxSlopeDelta * 2.0f );
+
+    return mGround;
   }
 
   const PxControllerCollisionFlags& CharacterPhysicsComponent::move(
@@ -3,6 +3,7 @@
 #include "Exception.h"
 #include "Utilities.h"
 #include "TextFile.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -20,6 +21,7 @@ namespace Glacier {
   const wchar_t* cConsoleErrorPrint = L"[%02d:%02d:%02d] [%s] ERROR: %s\r\n";
   const wchar_t* cConsoleVarOut     = L"%s is \"%s\"";
   const wchar_t* cConsoleUnknown    = L"Unknown command \"%s\"";
+  const size_t   cConsoleBufferLine = 256;
   COLORREF       cConsoleErrorColor = RGB(255,0,0);
 
   // ConBase class ============================================================
@@ -193,6 +195,11 @@ namespace Glacier {
   mOutFile( nullptr ), mCmdList( nullptr ), mCmdHelp( nullptr ),
   mCmdFind( nullptr ), mCmdExec( nullptr )
   {
+    // Preallocate command buffer slots so typical lines never allocate
+    for ( size_t i = 0; i < cConsoleBufferSize; i++ )
+      mCommandBuffer.getSlot( i ).reserve( cConsoleBufferLine );
+    mBufferedLine.reserve( cConsoleBufferLine );
+
     // Register console sources
     registerSource( L"engine", RGB(60,64,76) );
     registerSource( L"gfx", RGB(79,115,44) );
@@ -222,6 +229,8 @@ namespace Glacier {
 
   void Console::componentPreUpdate( GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     processBuffered();
   }
 
@@ -532,19 +541,19 @@ namespace Glacier {
 
   void Console::executeBuffered( const wstring& commandLine )
   {
-    ScopedRWLock lock( &mBufferLock );
-
-    mCommandBuffer.push( commandLine );
+    if ( !mCommandBuffer.push( commandLine ) )
+      errorPrintf( srcEngine, L"Command buffer full, dropped \"%s\"",
+        commandLine.c_str() );
   }
 
   void Console::processBuffered()
   {
-    ScopedRWLock lock( &mBufferLock );
-
-    while ( !mCommandBuffer.empty() )
+    // Bounded so commands queueing further commands can't stall the frame
+    for ( size_t i = 0; i < cConsoleBufferSize; i++ )
     {
-      execute( mCommandBuffer.front() );
-      mCommandBuffer.pop();
+      if ( !mCommandBuffer.pop( mBufferedLine ) )
+        break;
+      execute( mBufferedLine );
     }
   }
 
@@ -0,0 +1,424 @@
+#include "StdAfx.h"
+#include "CookedMeshCache.h"
+#include "PhysXPhysics.h"
+#include "Engine.h"
+#include "Exception.h"
+#include "Profiler.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  using namespace physx;
+
+  const char* cMeshCookerThreadName = "Mesh cooker";
+  const uint32_t cCookedMeshMagic = 'HSMC';
+  const uint32_t cCookedMeshVersion = 1;
+
+  ENGINE_DECLARE_CONCMD( px_meshcache,
+    L"Print cooked collision mesh cache statistics.", CookedMeshCache::callbackStats );
+
+  //! Header of a cooked mesh file, followed by the cooked stream.
+  struct CookedMeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    CookedMeshKey key;
+    uint32_t type;
+    uint32_t size; //!< Stream size in bytes
+  };
+
+  // MeshCooker class =========================================================
+
+  MeshCooker::MeshCooker( CookedMeshCache* cache ):
+  ThreadController( cMeshCookerThreadName, Step_OnWake ), mCache( cache )
+  {
+    //
+  }
+
+  void MeshCooker::onStart()
+  {
+    //
+  }
+
+  void MeshCooker::onStep()
+  {
+    mCache->cookQueued();
+  }
+
+  void MeshCooker::onPreStop()
+  {
+    //
+  }
+
+  void MeshCooker::onStop()
+  {
+    //
+  }
+
+  MeshCooker::~MeshCooker()
+  {
+    stop();
+  }
+
+  // CookedMeshCache class ====================================================
+
+  CookedMeshCache::CookedMeshCache( PxPhysics* physics, PxCooking* cooking,
+  const PxCookingParams& parameters, const wstring& directory ):
+  mPhysics( physics ), mCooking( cooking ), mParameterHash( Utilities::cFNVOffsetBasis ),
+  mDirectory( directory ), mCookedEvent( NULL ), mCooker( nullptr )
+  {
+    memset( &mStats, 0, sizeof( mStats ) );
+
+    // Anything that changes the cooked output must change the keys
+    uint32_t version = PX_PHYSICS_VERSION;
+    uint32_t platform = parameters.targetPlatform;
+    uint32_t preprocess = parameters.meshPreprocessParams;
+    mParameterHash = Utilities::fnv1a( &version, sizeof( version ), mParameterHash );
+    mParameterHash = Utilities::fnv1a( &platform, sizeof( platform ), mParameterHash );
+    mParameterHash = Utilities::fnv1a( &preprocess, sizeof( preprocess ), mParameterHash );
+    mParameterHash = Utilities::fnv1a( &parameters.meshWeldTolerance,
+      sizeof( parameters.meshWeldTolerance ), mParameterHash );
+    mParameterHash = Utilities::fnv1a( &parameters.convexEdgeThreshold,
+      sizeof( parameters.convexEdgeThreshold ), mParameterHash );
+    mParameterHash = Utilities::fnv1a( &parameters.areaTestEpsilon,
+      sizeof( parameters.areaTestEpsilon ), mParameterHash );
+    mParameterHash = Utilities::fnv1a( &parameters.scale, sizeof( parameters.scale ), mParameterHash );
+
+    CreateDirectoryW( mDirectory.c_str(), nullptr );
+
+    mCookedEvent = CreateEventW( NULL, FALSE, FALSE, NULL );
+    if ( !mCookedEvent )
+      ENGINE_EXCEPT_WINAPI( "Could not create mesh cooker event" );
+
+    mCooker = new MeshCooker( this );
+    mCooker->start();
+  }
+
+  CookedMeshKey CookedMeshCache::hash( const MeshSource& source ) const
+  {
+    uint32_t type = source.type;
+    uint32_t vertexCount = (uint32_t)source.vertices.size();
+    auto key = Utilities::fnv1a( &type, sizeof( type ), mParameterHash );
+    key = Utilities::fnv1a( &vertexCount, sizeof( vertexCount ), key );
+    key = Utilities::fnv1a( source.vertices.data(), source.vertices.size() * sizeof( PxVec3 ), key );
+    if ( source.type == CookedMesh_Triangle )
+      key = Utilities::fnv1a( source.indices.data(), source.indices.size() * sizeof( uint32_t ), key );
+
+    return key;
+  }
+
+  const wstring CookedMeshCache::getFilename( const CookedMeshKey key ) const
+  {
+    wchar_t name[32];
+    swprintf_s( name, 32, L"%016I64x.mesh", key );
+
+    return mDirectory + L"\\" + name;
+  }
+
+  bool CookedMeshCache::load( Entry* entry )
+  {
+    HANDLE file = CreateFileW( getFilename( entry->key ).c_str(), GENERIC_READ,
+      FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+    if ( file == INVALID_HANDLE_VALUE )
+      return false;
+
+    // The stream must fit in the file, or a corrupt size would have us
+    // allocate whatever it claims before finding out
+    LARGE_INTEGER fileSize;
+    CookedMeshFileHeader header;
+    DWORD read = 0;
+    bool valid = ( GetFileSizeEx( file, &fileSize )
+      && ReadFile( file, &header, sizeof( header ), &read, nullptr )
+      && read == sizeof( header )
+      && header.magic == cCookedMeshMagic
+      && header.version == cCookedMeshVersion
+      && header.key == entry->key
+      && header.type == (uint32_t)entry->type
+      && (uint64_t)fileSize.QuadPart == sizeof( header ) + (uint64_t)header.size );
+
+    if ( valid )
+    {
+      entry->stream.resize( header.size );
+      valid = ( ReadFile( file, entry->stream.data(), header.size, &read, nullptr )
+        && read == header.size );
+      if ( !valid )
+        entry->stream.clear();
+    }
+
+    CloseHandle( file );
+
+    return valid;
+  }
+
+  bool CookedMeshCache::save( Entry* entry )
+  {
+    // Write to a temporary first, so that a torn write never looks valid
+    auto filename = getFilename( entry->key );
+    auto temporary = filename + L".tmp";
+
+    HANDLE file = CreateFileW( temporary.c_str(), GENERIC_WRITE,
+      0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
+    if ( file == INVALID_HANDLE_VALUE )
+      return false;
+
+    CookedMeshFileHeader header = { cCookedMeshMagic, cCookedMeshVersion,
+      entry->key, (uint32_t)entry->type, (uint32_t)entry->stream.size() };
+
+    DWORD written;
+    BOOL ret = WriteFile( file, &header, sizeof( header ), &written, nullptr );
+    if ( ret )
+      ret = WriteFile( file, entry->stream.data(), (DWORD)entry->stream.size(), &written, nullptr );
+    CloseHandle( file );
+
+    if ( !ret || !MoveFileExW( temporary.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING ) )
+    {
+      DeleteFileW( temporary.c_str() );
+      return false;
+    }
+
+    return true;
+  }
+
+  bool CookedMeshCache::cook( Entry* entry )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    auto source = entry->source;
+    PxDefaultMemoryOutputStream stream;
+
+    bool cooked = false;
+    if ( entry->type == CookedMesh_Triangle )
+    {
+      PxTriangleMeshDesc descriptor;
+      descriptor.points.count = (PxU32)source->vertices.size();
+      descriptor.points.stride = sizeof( PxVec3 );
+      descriptor.points.data = source->vertices.data();
+      descriptor.triangles.count = (PxU32)( source->indices.size() / 3 );
+      descriptor.triangles.stride = 3 * sizeof( uint32_t );
+      descriptor.triangles.data = source->indices.data();
+      cooked = ( descriptor.isValid() && mCooking->cookTriangleMesh( descriptor, stream ) );
+    }
+    else
+    {
+      PxConvexMeshDesc descriptor;
+      descriptor.points.count = (PxU32)source->vertices.size();
+      descriptor.points.stride = sizeof( PxVec3 );
+      descriptor.points.data = source->vertices.data();
+      descriptor.flags = PxConvexFlag::eCOMPUTE_CONVEX;
+      cooked = ( descriptor.isValid() && mCooking->cookConvexMesh( descriptor, stream ) );
+    }
+
+    if ( !cooked )
+      return false;
+
+    entry->stream.assign( stream.getData(), stream.getData() + stream.getSize() );
+
+    return true;
+  }
+
+  void CookedMeshCache::cookQueued()
+  {
+    while ( true )
+    {
+      Entry* entry;
+      {
+        ScopedRWLock lock( &mLock );
+        if ( mQueue.empty() )
+          break;
+        entry = mQueue.front();
+        mQueue.pop_front();
+      }
+
+      // Disk first, cook & store only what isn't there
+      bool fromDisk = load( entry );
+      bool ready = ( fromDisk || cook( entry ) );
+      if ( ready && !fromDisk )
+        save( entry );
+
+      {
+        ScopedRWLock lock( &mLock );
+        SAFE_DELETE( entry->source );
+        entry->state = ( ready ? State_Ready : State_Failed );
+        if ( fromDisk )
+          mStats.diskHits++;
+        else if ( ready )
+          mStats.cooked++;
+        else
+          mStats.failed++;
+      }
+
+      SetEvent( mCookedEvent );
+    }
+  }
+
+  CookedMeshCache::Entry* CookedMeshCache::request( const MeshSource& source )
+  {
+    auto key = hash( source );
+
+    ScopedRWLock lock( &mLock );
+
+    auto it = mEntries.find( key );
+    if ( it != mEntries.end() )
+    {
+      mStats.memoryHits++;
+      return it->second;
+    }
+
+    auto entry = new Entry();
+    entry->key = key;
+    entry->type = source.type;
+    entry->state = State_Queued;
+    entry->source = new MeshSource( source );
+    entry->mesh = nullptr;
+    mEntries[key] = entry;
+    mQueue.push_back( entry );
+    lock.unlock();
+
+    mCooker->wake();
+
+    return entry;
+  }
+
+  PxBase* CookedMeshCache::acquire( const MeshSource& source )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    auto entry = request( source );
+
+    while ( entry->state == State_Queued )
+      WaitForSingleObject( mCookedEvent, 10 );
+
+    if ( entry->state != State_Ready )
+      return nullptr;
+
+    ScopedRWLock lock( &mLock );
+
+    // Create the mesh once, and let go of the stream it came from
+    if ( !entry->mesh )
+    {
+      PxDefaultMemoryInputData input( entry->stream.data(), (PxU32)entry->stream.size() );
+      if ( entry->type == CookedMesh_Triangle )
+        entry->mesh = mPhysics->createTriangleMesh( input );
+      else
+        entry->mesh = mPhysics->createConvexMesh( input );
+      if ( !entry->mesh )
+      {
+        entry->state = State_Failed;
+        return nullptr;
+      }
+      vector<uint8_t>().swap( entry->stream );
+    }
+
+    return entry->mesh;
+  }
+
+  CookedMeshKey CookedMeshCache::prefetch( const MeshSource& source )
+  {
+    return request( source )->key;
+  }
+
+  const CookedMeshCache::State CookedMeshCache::getState( const CookedMeshKey key )
+  {
+    ScopedRWLock lock( &mLock, false );
+
+    auto it = mEntries.find( key );
+    if ( it == mEntries.end() )
+      return State_Failed;
+
+    return it->second->state;
+  }
+
+  PxTriangleMesh* CookedMeshCache::acquireTriangleMesh( const MeshSource& source )
+  {
+    assert( source.type == CookedMesh_Triangle );
+
+    auto mesh = acquire( source );
+
+    return ( mesh ? mesh->is<PxTriangleMesh>() : nullptr );
+  }
+
+  PxConvexMesh* CookedMeshCache::acquireConvexMesh( const MeshSource& source )
+  {
+    assert( source.type == CookedMesh_Convex );
+
+    auto mesh = acquire( source );
+
+    return ( mesh ? mesh->is<PxConvexMesh>() : nullptr );
+  }
+
+  void CookedMeshCache::flush()
+  {
+    while ( true )
+    {
+      {
+        ScopedRWLock lock( &mLock, false );
+        bool cooking = !mQueue.empty();
+        for ( auto& it : mEntries )
+          cooking = ( cooking || it.second->state == State_Queued );
+        if ( !cooking )
+          break;
+      }
+      WaitForSingleObject( mCookedEvent, 10 );
+    }
+  }
+
+  void CookedMeshCache::clear()
+  {
+    flush();
+
+    ScopedRWLock lock( &mLock );
+
+    // Shapes hold their own references, so meshes in use live on
+    for ( auto& it : mEntries )
+    {
+      if ( it.second->mesh )
+        it.second->mesh->release();
+      delete it.second;
+    }
+    mEntries.clear();
+  }
+
+  CookedMeshCache::~CookedMeshCache()
+  {
+    clear();
+    SAFE_DELETE( mCooker );
+    if ( mCookedEvent )
+      CloseHandle( mCookedEvent );
+  }
+
+  void CookedMeshCache::callbackStats( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getPhysics() || !gEngine->getPhysics()->getMeshCache() )
+      return;
+
+    auto cache = gEngine->getPhysics()->getMeshCache();
+
+    ScopedRWLock lock( &cache->mLock, false );
+
+    size_t meshes = 0, streams = 0, bytes = 0;
+    for ( auto& it : cache->mEntries )
+    {
+      if ( it.second->mesh )
+        meshes++;
+      else if ( !it.second->stream.empty() )
+      {
+        streams++;
+        bytes += it.second->stream.size();
+      }
+    }
+
+    console->printf( Console::srcPhysics,
+      L"Entries: %d, %d meshes created, %d streams held (%d bytes), %d queued",
+      (int)cache->mEntries.size(), (int)meshes, (int)streams, (int)bytes,
+      (int)cache->mQueue.size() );
+    console->printf( Console::srcPhysics,
+      L"Memory hits: %I64u, disk hits: %I64u, cooked: %I64u, failed: %I64u",
+      cache->mStats.memoryHits, cache->mStats.diskHits,
+      cache->mStats.cooked, cache->mStats.failed );
+    console->printf( Console::srcPhysics,
+      L"Disk cache: %s", cache->mDirectory.c_str() );
+  }
+
+}
\ No newline at end of file
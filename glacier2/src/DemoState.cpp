@@ -29,6 +29,23 @@
 namespace Glacier {
 
   const string cDemoStateTitle( "glacier² » demo" );
+  const wchar_t* cDemoLevelPhysics = L"demo.pxcollection";
+
+  //! Demo level layout, hashed to tell when the saved physics are stale.
+  struct DemoLevel {
+    Real size; //!< Ground plane width & height
+    struct Pillar {
+      Vector3 size;
+      Vector3 position;
+    } pillars[4];
+  };
+
+  const DemoLevel cDemoLevel = { 128.0f, {
+    { Vector3( 1.0f, 10.0f, 1.0f ), Vector3( -5.5f, 5.0f, 5.5f ) },
+    { Vector3( 1.0f, 10.0f, 1.0f ), Vector3( 5.5f, 5.0f, -5.5f ) },
+    { Vector3( 1.0f, 10.0f, 1.0f ), Vector3( 5.5f, 5.0f, 5.5f ) },
+    { Vector3( 1.0f, 10.0f, 1.0f ), Vector3( -5.5f, 5.0f, -5.5f ) }
+  } };
 
   DemoState::DemoState(): State( L"Demo" ) {}
 
@@ -36,17 +53,63 @@ namespace Glacier {
   {
     State::initialize( game, time );
 
-    Locator::getGraphics().setRenderWindowTitle( cDemoStateTitle );
+    mDirector = nullptr;
+    mNavigationMesh = nullptr;
+    mNavVis = nullptr;
+    mLevelPhysics = nullptr;
+
+    bool headless = !Locator::hasGraphics();
+
+    if ( !headless )
+      Locator::getGraphics().setRenderWindowTitle( cDemoStateTitle );
+
+    // Level actors come in with a single insertion if we've saved them before,
+    // and from the same layout; the SDK version is checked on import
+    auto physics = gEngine->getWorld()->getPhysics();
+    auto levelHash = Utilities::fnv1a( &cDemoLevel, sizeof( cDemoLevel ) );
+    mLevelPhysics = physics->importCollection( cDemoLevelPhysics, levelHash );
+    bool physical = !mLevelPhysics;
 
     Ogre::Plane plane( Vector3::UNIT_Y, 0.0f );
-    Real width = 128.0f;
-    Real height = 128.0f;
-    mPrimitives.push_back( new Primitives::Plane( gEngine->getWorld()->getPhysics(), plane, width, height, Vector3::ZERO, 32.0f, 32.0f ) );
-    mPrimitives.push_back( new Primitives::Box( gEngine->getWorld()->getPhysics(), Vector3( 1.0f, 10.0f, 1.0f ), Vector3( -5.5f, 5.0f, 5.5f ), Quaternion::IDENTITY ) );
-    mPrimitives.push_back( new Primitives::Box( gEngine->getWorld()->getPhysics(), Vector3( 1.0f, 10.0f, 1.0f ), Vector3( 5.5f, 5.0f, -5.5f ), Quaternion::IDENTITY ) );
-    mPrimitives.push_back( new Primitives::Box( gEngine->getWorld()->getPhysics(), Vector3( 1.0f, 10.0f, 1.0f ), Vector3( 5.5f, 5.0f, 5.5f ), Quaternion::IDENTITY ) );
-    mPrimitives.push_back( new Primitives::Box( gEngine->getWorld()->getPhysics(), Vector3( 1.0f, 10.0f, 1.0f ), Vector3( -5.5f, 5.0f, -5.5f ), Quaternion::IDENTITY ) );
+    mPrimitives.push_back( new Primitives::Plane( physics, plane, cDemoLevel.size, cDemoLevel.size, Vector3::ZERO, 32.0f, 32.0f, physical ) );
+    for ( auto& pillar : cDemoLevel.pillars )
+      mPrimitives.push_back( new Primitives::Box( physics, pillar.size, pillar.position, Quaternion::IDENTITY, physical ) );
+
+    // Nothing but the level is in the scene yet, so save it for next time
+    if ( physical )
+      physics->exportCollection( cDemoLevelPhysics, physx::PxActorTypeFlag::eRIGID_STATIC, levelHash );
+
+    // The navigation mesh is built from render geometry, so headless runs go without
+    if ( !headless )
+      buildNavigation();
+
+    auto player = Locator::getEntities().create( "player", "player" );
+    if ( gEngine->getInput() )
+      gEngine->getInput()->getLocalController()->setCharacter( (Character*)player );
+    player->spawn( Vector3( 0.0f, 1.0f, 0.0f ), Quaternion::IDENTITY );
+
+    auto dummy = Locator::getEntities().create( "dev_dummy" );
+    dummy->spawn( Vector3( 0.0f, 1.0f, 5.0f ), Quaternion::IDENTITY );
+
+    // Drop the cubes in as one batch
+    const Entities::DevCube::Type smallCube = Entities::DevCube::DevCube_025;
+    const Entities::DevCube::Type largeCube = Entities::DevCube::DevCube_050;
+    EntitySpawnVector cubes;
+    cubes.reserve( 20 );
+    for ( int i = 1; i < 11; i++ )
+      cubes.push_back( EntitySpawn( "dev_cube", Vector3( 5.0f, i * 15.0f, 0.0f ), Quaternion::IDENTITY, &smallCube ) );
+    for ( int i = 1; i < 11; i++ )
+      cubes.push_back( EntitySpawn( "dev_cube", Vector3( -5.0f, i * 15.0f, 0.0f ), Quaternion::IDENTITY, &largeCube ) );
+    Locator::getEntities().spawnBatch( cubes.data(), cubes.size() );
+
+    if ( !headless )
+      mDirector = new Director( &Locator::getGraphics(), player->getNode() );
+
+    Locator::getMusic().beginScene();
+  }
 
+  void DemoState::buildNavigation()
+  {
     // TODO this really needs to be in a background thread. or something.
     OgreItemVector navSources;
     for ( auto primitive : mPrimitives )
@@ -76,30 +139,6 @@ namespace Glacier {
     mNavVis = new NavigationDebugVisualizer( gEngine );
     duDebugDrawPolyMesh( mNavVis, *mNavigationMesh->getPolyMesh() );
 #endif
-
-    auto player = Locator::getEntities().create( "player", "player" );
-    gEngine->getInput()->getLocalController()->setCharacter( (Character*)player );
-    player->spawn( Vector3( 0.0f, 1.0f, 0.0f ), Quaternion::IDENTITY );
-
-    auto dummy = Locator::getEntities().create( "dev_dummy" );
-    dummy->spawn( Vector3( 0.0f, 1.0f, 5.0f ), Quaternion::IDENTITY );
-
-    for ( int i = 1; i < 11; i++ )
-    {
-      auto cube = (Entities::DevCube*)Locator::getEntities().create( "dev_cube" );
-      cube->setType( Entities::DevCube::DevCube_025 );
-      cube->spawn( Vector3( 5.0f, i * 15.0f, 0.0f ), Quaternion::IDENTITY );
-    }
-    for ( int i = 1; i < 11; i++ )
-    {
-      auto cube = ( Entities::DevCube* )Locator::getEntities().create( "dev_cube" );
-      cube->setType( Entities::DevCube::DevCube_050 );
-      cube->spawn( Vector3( -5.0f, i * 15.0f, 0.0f ), Quaternion::IDENTITY );
-    }
-
-    mDirector = new Director( &Locator::getGraphics(), player->getNode() );
-
-    Locator::getMusic().beginScene();
   }
 
   void DemoState::pause( GameTime time )
@@ -114,7 +153,8 @@ namespace Glacier {
 
   void DemoState::update( GameTime tick, GameTime time )
   {
-    mDirector->update( tick );
+    if ( mDirector )
+      mDirector->update( tick );
   }
 
   void DemoState::draw( GameTime delta, GameTime time )
@@ -124,7 +164,8 @@ namespace Glacier {
 
   void DemoState::shutdown( GameTime time )
   {
-    gEngine->getInput()->getLocalController()->setCharacter( nullptr );
+    if ( gEngine->getInput() )
+      gEngine->getInput()->getLocalController()->setCharacter( nullptr );
     Locator::getEntities().clear();
     Locator::getMusic().endScene();
 #ifndef GLACIER_NO_NAVIGATION_DEBUG
@@ -133,6 +174,9 @@ namespace Glacier {
     SAFE_DELETE( mNavigationMesh );
     for ( auto primitive : mPrimitives )
       delete primitive;
+    if ( mLevelPhysics )
+      gEngine->getWorld()->getPhysics()->releaseCollection( mLevelPhysics );
+    mLevelPhysics = nullptr;
     SAFE_DELETE( mDirector );
 
     State::shutdown( time );
@@ -12,6 +12,7 @@
 #include "Entity.h"
 #include "DeveloperEntities.h"
 #include "World.h"
+#include "TransformStore.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -24,9 +25,14 @@ namespace Glacier {
 
     ENGINE_DECLARE_ENTITY( dev_cube, DevCube );
 
-    DevCube::DevCube( World* world ): Entity( world, &baseData ), mType( DevCube_025 )
+    Ogre::MeshPtr DevCube::fMeshes[DevCube::cTypeCount];
+    uint32_t DevCube::fMeshUsers[DevCube::cTypeCount] = { 0 };
+
+    DevCube::DevCube( World* world ): Entity( world, &baseData ),
+    mActor( nullptr ), mItem( nullptr ), mType( DevCube_025 )
     {
-      //
+      // Pose is read back by the transform store, nothing to think about
+      setThinkInterval( 0 );
     }
 
     Ogre::MovableObject* DevCube::getMovable()
@@ -34,11 +40,22 @@ namespace Glacier {
       return mItem;
     }
 
+    physx::PxRigidActor* DevCube::getActor()
+    {
+      return mActor;
+    }
+
     void DevCube::setType( const Type type )
     {
       mType = type;
     }
 
+    void DevCube::configure( const void* parameters )
+    {
+      if ( parameters )
+        setType( *(const Type*)parameters );
+    }
+
     void DevCube::spawn( const Vector3& position, const Quaternion& orientation )
     {
       Entity::spawn( position, orientation );
@@ -47,8 +64,8 @@ namespace Glacier {
       auto scene = mWorld->getPhysics();
 
       PxTransform transform;
-      transform.p = Math::ogreVec3ToPx( mPosition );
-      transform.q = Math::ogreQtToPx( mOrientation );
+      transform.p = Math::ogreVec3ToPx( position );
+      transform.q = Math::ogreQtToPx( orientation );
 
       if ( mType == DevCube_025 )
       {
@@ -60,11 +77,7 @@ namespace Glacier {
         if ( !mActor )
           ENGINE_EXCEPT( "Could not create physics plane actor" );
 
-        scene->getScene()->addActor( *mActor );
-
-        mMesh = Procedural::BoxGenerator().setSizeX( 0.25f ).setSizeY( 0.25f ).setSizeZ( 0.25f ).realizeMesh();
-        mItem = Locator::getGraphics().getScene()->createItem( mMesh );
-        mItem->setDatablock( "Developer/Cube025" );
+        scene->addActor( *mActor );
       }
       else if ( mType == DevCube_050 )
       {
@@ -76,12 +89,26 @@ namespace Glacier {
         if ( !mActor )
           ENGINE_EXCEPT( "Could not create physics plane actor" );
 
-        scene->getScene()->addActor( *mActor );
+        scene->addActor( *mActor );
+      }
+
+      // The transform store reads our pose back along with everyone else's
+      mWorld->getTransforms()->setActor( mTransform, mActor );
+
+      if ( !mNode )
+        return;
 
-        mMesh = Procedural::BoxGenerator().setSizeX( 0.5f ).setSizeY( 0.5f ).setSizeZ( 0.5f ).realizeMesh();
-        mItem = Locator::getGraphics().getScene()->createItem( mMesh );
-        mItem->setDatablock( "Developer/Cube050" );
+      // Generate each type's mesh once and share it
+      auto& mesh = fMeshes[mType];
+      if ( mesh.isNull() )
+      {
+        Real size = ( mType == DevCube_025 ? 0.25f : 0.5f );
+        mesh = Procedural::BoxGenerator().setSizeX( size ).setSizeY( size ).setSizeZ( size ).realizeMesh();
       }
+      fMeshUsers[mType]++;
+
+      mItem = Locator::getGraphics().getScene()->createItem( mesh );
+      mItem->setDatablock( mType == DevCube_025 ? "Developer/Cube025" : "Developer/Cube050" );
 
       mItem->setCastShadows( true );
       mNode->attachObject( mItem );
@@ -89,23 +116,22 @@ namespace Glacier {
 
     void DevCube::think( const GameTime delta )
     {
-      // No thinking for me
-    }
-
-    void DevCube::visualize()
-    {
-      PxTransform& transform = mActor->getGlobalPose();
-      mNode->setPosition( Math::pxVec3ToOgre( transform.p ) );
-      mNode->setOrientation( Math::pxQtToOgre( transform.q ) );
+      // Never called
     }
 
     DevCube::~DevCube()
     {
       if ( mItem )
+      {
         Locator::getGraphics().getScene()->destroyItem( mItem );
 
-      if ( !mMesh.isNull() )
-        Ogre::MeshManager::getSingleton().remove( mMesh->getHandle() );
+        // Last cube of its type out removes the shared mesh
+        if ( --fMeshUsers[mType] == 0 )
+        {
+          Ogre::MeshManager::getSingleton().remove( fMeshes[mType]->getHandle() );
+          fMeshes[mType].setNull();
+        }
+      }
 
       mWorld->getPhysics()->getScene()->removeActor( *mActor );
     }
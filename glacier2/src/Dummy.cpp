@@ -29,7 +29,7 @@ namespace Glacier {
     {
       AI::State::execute( machine, agent, delta );
       auto dummy = (Dummy*)agent;
-      auto player = dummy->getWorld()->getEntities()->findByName( "player" );
+      auto player = dummy->getTarget();
       if ( !player || !dummy->canSee( player ) )
         machine->popState();
     }
@@ -49,7 +49,7 @@ namespace Glacier {
     {
       AI::State::execute( machine, agent, delta );
       auto dummy = (Dummy*)agent;
-      auto player = dummy->getWorld()->getEntities()->findByName( "player" );
+      auto player = dummy->getTarget();
       if ( player && dummy->canSee( player ) )
         machine->pushState( &dummyAlertState );
     }
@@ -60,7 +60,7 @@ namespace Glacier {
   Dummy::Dummy( World* world ):
   Character( world, &baseData, new AICharacterInputComponent( this ) ),
   AI::Agent(),
-  mItem( nullptr ), mStates( this )
+  mItem( nullptr ), mEyeNode( nullptr ), mStates( this )
   {
     mEyePosition = Vector3( 0.0f, 0.5f, 0.0f );
     mFieldOfView = Radian( Ogre::Degree( 50.0f ) );
@@ -68,6 +68,7 @@ namespace Glacier {
     mStates.pushState( &dummyIdleState );
     mHeight = 0.8f;
     mRadius = 0.2f;
+    mVisualizes = true;
   }
 
   AICharacterInputComponent* Dummy::getInput()
@@ -80,10 +81,26 @@ namespace Glacier {
     return mFovCone;
   }
 
+  Entity* Dummy::getTarget()
+  {
+    auto entities = mWorld->getEntities();
+    auto target = entities->get( mTarget );
+    if ( !target )
+    {
+      target = entities->findByName( "player" );
+      if ( target )
+        mTarget = target->getHandle();
+    }
+    return target;
+  }
+
   void Dummy::spawn( const Vector3& position, const Quaternion& orientation )
   {
     Character::spawn( position, orientation );
 
+    if ( !mNode )
+      return;
+
     mMesh = Procedural::CapsuleGenerator( mRadius, mHeight, 8, 16, 1 ).realizeMesh();
 
     mItem = Locator::getGraphics().getScene()->createItem( mMesh );
@@ -102,18 +119,21 @@ namespace Glacier {
     mNode->addChild( mEyeNode );
   }
 
-  void Dummy::think( const GameTime delta )
+  void Dummy::prethink( const GameTime delta )
   {
     mStates.execute( delta );
-    Character::think( delta );
     Quaternion qt;
-    qt.FromAngleAxis( Degree( 0.5f ), Vector3::UNIT_Y );
+    qt.FromAngleAxis( Degree( 30.0f * (Real)delta ), Vector3::UNIT_Y );
     mFacing = qt * mFacing;
   }
 
-  void Dummy::visualize()
+  void Dummy::think( const GameTime delta )
+  {
+    Character::think( delta );
+  }
+
+  void Dummy::visualize( const GameTime alpha )
   {
-    Character::visualize();
     mNode->setDirection( mFacing, Ogre::Node::TS_WORLD );
   }
 
@@ -124,7 +144,8 @@ namespace Glacier {
 
   Dummy::~Dummy()
   {
-    mEyeNode->removeAllChildren();
+    if ( mEyeNode )
+      mEyeNode->removeAllChildren();
     if ( mItem )
       Locator::getGraphics().getScene()->destroyItem( mItem );
     if ( !mMesh.isNull() )
@@ -15,6 +15,12 @@
 #include "EntityManager.h"
 #include "World.h"
 #include "Navigation.h"
+#include "JobSystem.h"
+#include "TickScheduler.h"
+#include "FrameGovernor.h"
+#include "FrameStatistics.h"
+#include "ThreadPlacement.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -24,7 +30,7 @@ Glacier::Engine* gEngine = nullptr;
 namespace Glacier {
 
   Engine::Options::Options():
-  noAudio( false ), noPhysics( false )
+  noAudio( false ), noPhysics( false ), headless( false )
   {
     //
   }
@@ -35,8 +41,10 @@ namespace Glacier {
   GameTime Engine::fTimeDelta = 0.0;
   GameTime Engine::fTimeAccumulator = 0.0;
   GameTime Engine::fLogicStep = 1.0 / 60.0;
+  GameTime Engine::fTimeAlpha = 0.0;
 
   const std::string cMainThreadName = "Gcr2 Main Thread";
+  const char* cHeadlessLogFile = "ogre_headless.log";
 
   // Engine version struct ====================================================
 
@@ -63,6 +71,12 @@ namespace Glacier {
     L"Save a screenshot to working directory.", Engine::callbackScreenshot );
   ENGINE_DECLARE_CONCMD( quit,
     L"Quit.", Engine::callbackQuit );
+  ENGINE_DECLARE_CONVAR( eng_tickrate,
+    L"Game logic steps per second. Applied on restart.", 60 );
+  ENGINE_DECLARE_CONVAR( eng_unthrottled,
+    L"When headless, run logic steps back to back instead of in realtime.", false );
+  ENGINE_DECLARE_CONVAR( eng_timelimit,
+    L"Stop the engine after this many seconds of game time. 0 = No limit.", 0.0f );
 
   Engine::Engine( HINSTANCE instance ):
   mConsole( nullptr ), mScripting( nullptr ), mGraphics( nullptr ),
@@ -70,41 +84,40 @@ namespace Glacier {
   mSignal( Signal_None ), mVersion( 0, 1, 1 ), mConsoleWindow( nullptr ),
   mGame( nullptr ), mWindowHandler( nullptr ), mInput( nullptr ),
   mAudio( nullptr ), mPhysics( nullptr ),
-  mEntities( nullptr ), mNavigation( nullptr )
+  mEntities( nullptr ), mNavigation( nullptr ), mJobs( nullptr ),
+  mScheduler( nullptr ), mGovernor( nullptr ), mFrameStats( nullptr ),
+  mPlacement( nullptr ), mHeadlessRoot( nullptr ),
+  mHeadless( false )
   {
   }
 
   void Engine::fixupThreadAffinity()
   {
-    DWORD_PTR processMask, systemMask;
+    mPlacement->place( mThread, GetCurrentThreadId(),
+      ThreadPlacement::Role_Main, 0, L"Main" );
 
-    if ( !GetProcessAffinityMask( mProcess, &processMask, &systemMask ) )
-    {
+    DWORD_PTR mask = mPlacement->getMask( ThreadPlacement::Role_Main, 0 );
+    if ( mask )
       getConsole()->printf( Console::srcEngine,
-        L"Could not query process affinity mask - thread affinity may fluctuate" );
-      return;
-    }
-
-    if ( processMask == 0 )
-      processMask = 1;
-
-    uint32_t core = 1;
-    DWORD_PTR engineMask = 1;
-
-    while ( ( engineMask & processMask ) == 0 )
-    {
-      core++;
-      engineMask <<= 1;
-    }
-
-    uint32_t cores = Utilities::hammingWeight64( processMask );
+        L"Fixating engine main thread to mask 0x%I64x", (uint64_t)mask );
+  }
 
-    getConsole()->printf( Console::srcEngine,
-      L"Fixating engine main thread to core %d (out of %d)", core, cores );
+  void Engine::componentTickJob( Job* job, const void* data )
+  {
+    auto tick = (const ComponentTickJob*)data;
+    tick->component->componentTick( tick->tick, tick->time );
+  }
 
-    if ( !SetThreadAffinityMask( mThread, engineMask ) )
-      getConsole()->errorPrintf( Console::srcEngine,
-        L"Failed to set thread affinity mask" );
+  uint32_t Engine::getJobWorkerCount()
+  {
+    if ( g_CVar_job_workers.getInt() > 0 )
+      return (uint32_t)g_CVar_job_workers.getInt();
+
+    // One worker per physical core left over from the main thread and
+    // physics dispatch, SMT siblings would only contend for the same core
+    uint32_t cores = mPlacement->getCoreCount();
+    uint32_t reserved = 1 + mPlacement->getPhysicsThreads();
+    return ( cores > reserved ? cores - reserved : 0 );
   }
 
   void Engine::operationSuspendVideo()
@@ -176,11 +189,17 @@ namespace Glacier {
     mThread = GetCurrentThread();
 
     Utilities::debugSetThreadName( GetCurrentThreadId(), cMainThreadName );
+    Profiler::setThreadName( cMainThreadName );
+
+    mHeadless = options.headless;
 
     // Setup console
     mConsole = new Console( this );
-    mConsoleWindow = new ConsoleWindowThread( mInstance, mConsole );
-    mConsoleWindow->start();
+    if ( !mHeadless )
+    {
+      mConsoleWindow = new ConsoleWindowThread( mInstance, mConsole );
+      mConsoleWindow->start();
+    }
 
     // Print engine info
     mConsole->printf( Console::srcEngine, getVersion().title.c_str() );
@@ -190,25 +209,64 @@ namespace Glacier {
     if ( !QueryPerformanceFrequency( &mHPCFrequency ) )
       ENGINE_EXCEPT_WINAPI( "Couldn't query HPC frequency" );
 
-    mWindowHandler = new WindowHandler( this );
-    mGraphics = new Graphics( this, mWindowHandler );
-    Locator::provideGraphics( mGraphics );
+    if ( mHeadless )
+    {
+      // We still need Ogre's resource system for configs & scripts
+      mConsole->printf( Console::srcEngine, L"Init: Running headless" );
+      mHeadlessRoot = new Ogre::Root( "", "", cHeadlessLogFile );
+      registerUserLocations( ResourceGroupManager::getSingleton() );
+    }
+    else
+    {
+      mWindowHandler = new WindowHandler( this );
+      mGraphics = new Graphics( this, mWindowHandler );
+      Locator::provideGraphics( mGraphics );
+    }
 
     mConsole->executeFile( L"user.cfg" );
     for ( auto exec : options.additionalExecs )
       mConsole->executeFile( exec );
 
-    mGraphics->postInitialize();
+    // Place threads now that the policy has been loaded
+    mPlacement = new ThreadPlacement( this,
+      (uint32_t)std::max( g_CVar_px_threads.getInt(), 0 ) );
+    if ( mConsoleWindow )
+      mPlacement->place( mConsoleWindow->getThread(), mConsoleWindow->getThreadID(),
+        ThreadPlacement::Role_IO, 0, L"Console window" );
+
+    mJobs = new JobSystem( this, getJobWorkerCount() );
+    for ( uint32_t i = 0; i < mJobs->getWorkerCount(); i++ )
+    {
+      auto worker = mJobs->getWorker( i );
+      mPlacement->place( worker->getThread(), worker->getThreadID(),
+        ThreadPlacement::Role_Worker, i,
+        wstring( worker->getName().begin(), worker->getName().end() ) );
+    }
+
+    mScheduler = new TickScheduler( this );
+    mScheduler->addSlot( TickSlot_Input, L"Input", &g_CVar_in_tickrate );
+    mScheduler->addSlot( TickSlot_Game, L"Game", &g_CVar_g_tickrate );
+    mScheduler->addSlot( TickSlot_AI, L"AI", &g_CVar_ai_tickrate );
+    mScheduler->addSlot( TickSlot_Audio, L"Audio", &g_CVar_fm_tickrate );
+
+    mGovernor = new FrameGovernor( this );
+    mFrameStats = new FrameStatistics( this );
+
+    if ( mHeadless )
+      Scripting::registerResources( ResourceGroupManager::getSingleton() );
+    else
+      mGraphics->postInitialize();
 
     mScripting = new Scripting( this );
     mScripting->simpleExecute( L"initialization.js" );
 
-    mInput = new InputManager( this, mInstance, mGraphics->getWindow() );
+    if ( !mHeadless )
+      mInput = new InputManager( this, mInstance, mGraphics->getWindow() );
 
     mPhysics = new PhysXPhysics( this );
     Locator::providePhysics( mPhysics );
 
-    if ( !options.noAudio )
+    if ( !options.noAudio && !mHeadless )
     {
       try
       {
@@ -232,8 +290,11 @@ namespace Glacier {
 
     mGame = new Game( this );
 
-    SetFocus( mGraphics->getRenderWindowHandle() );
-    mInput->onInputFocus( true );
+    if ( !mHeadless )
+    {
+      SetFocus( mGraphics->getRenderWindowHandle() );
+      mInput->onInputFocus( true );
+    }
   }
 
   void Engine::signalStop()
@@ -258,19 +319,32 @@ namespace Glacier {
   {
     fixupThreadAffinity();
 
+    LARGE_INTEGER timeStart;
     LARGE_INTEGER timeCurrent;
     LARGE_INTEGER tickDelta;
     LARGE_INTEGER timeNew;
 
     QueryPerformanceCounter( &timeCurrent );
+    timeStart = timeCurrent;
 
     fTime = 0.0;
     fTimeAccumulator = 0.0;
+    fTimeAlpha = 0.0;
+    fLogicStep = 1.0 / (GameTime)std::max( g_CVar_eng_tickrate.getInt(), 1 );
+    mScheduler->configure( fLogicStep );
+
+    GameTime slotTick;
 
     while ( mSignal != Signal_Stop )
     {
+      GLACIER_PROFILE( "Engine::frame" );
+
+      mGovernor->beginFrame();
+      mFrameStats->beginFrame();
+
       mConsole->componentPreUpdate( fTime );
-      mGraphics->componentPreUpdate( fTime );
+      if ( mGraphics )
+        mGraphics->componentPreUpdate( fTime );
 
       QueryPerformanceCounter( &timeNew );
 
@@ -278,33 +352,102 @@ namespace Glacier {
       timeCurrent = timeNew;
 
       // Make frame delta and accumulate stepping
-      fTimeDelta = (GameTime)tickDelta.QuadPart / (GameTime)mHPCFrequency.QuadPart;
+      // An unthrottled headless engine just runs one step per frame, flat out
+      if ( mHeadless && g_CVar_eng_unthrottled.getBool() )
+        fTimeDelta = fLogicStep;
+      else
+        fTimeDelta = (GameTime)tickDelta.QuadPart / (GameTime)mHPCFrequency.QuadPart;
       fTimeAccumulator += fTimeDelta;
 
-      // Run logic steps
+      // Don't spiral to death trying to catch up after a long frame
+      fTimeAccumulator = mGovernor->limitCatchUp( fTimeAccumulator, fLogicStep );
+
+      mFrameStats->lap( FrameSection_PreUpdate );
+
+      // Run logic steps, at least one if due but no more than the budget allows
+      uint32_t steps = 0;
       while ( fTimeAccumulator >= fLogicStep )
       {
+        if ( steps > 0 && mGovernor->isOverBudget() )
+          break;
+        steps++;
+        GLACIER_PROFILE( "Engine::step" );
+        mFrameStats->beginStep();
+        // Components may parent jobs to the step, wait for all of them
+        mJobs->beginStep();
+        mEntities->beginStep();
+        // Physics may keep simulating until synced below,
+        // anything in between must not touch the physics scenes
         if ( mPhysics )
           mPhysics->componentTick( fLogicStep, fTime );
-        mInput->componentTick( fLogicStep, fTime );
-        mGame->componentTick( fLogicStep, fTime );
+        mFrameStats->lap( FrameSection_Physics );
+        if ( mScheduler->isDue( TickSlot_Input, slotTick ) && mInput )
+          mInput->componentTick( slotTick, fTime );
+        mFrameStats->lap( FrameSection_Input );
+        if ( mScheduler->isDue( TickSlot_Game, slotTick ) )
+          mGame->componentTick( slotTick, fTime );
+        // Let physics move on to its next substep without waiting
+        if ( mPhysics )
+          mPhysics->simulationPoll();
+        mFrameStats->lap( FrameSection_Game );
+        if ( mScheduler->isDue( TickSlot_AI, slotTick ) )
+          mEntities->prethink( slotTick, fTime );
+        if ( mPhysics )
+          mPhysics->simulationPoll();
+        mFrameStats->lap( FrameSection_AI );
+        // Nothing else calls into FMOD until the step has ended, so the
+        // sound engine ticks alongside physics sync & entity think
+        if ( mScheduler->isDue( TickSlot_Audio, slotTick ) && mAudio )
+        {
+          ComponentTickJob audio = { mAudio, slotTick, fTime };
+          mJobs->run( mJobs->createChild( mJobs->getStepJob(),
+            componentTickJob, &audio, sizeof( audio ) ) );
+        }
+        mFrameStats->lap( FrameSection_Audio );
+        if ( mPhysics )
+          mPhysics->simulationSync();
+        mFrameStats->lap( FrameSection_Physics );
         mEntities->componentTick( fLogicStep, fTime );
-        if ( mAudio )
-          mAudio->componentTick( fLogicStep, fTime );
+        mJobs->endStep();
+        mFrameStats->lap( FrameSection_Entities );
+        mFrameStats->endStep();
+        mScheduler->advance();
         fTime += fLogicStep;
         fTimeAccumulator -= fLogicStep;
       }
 
+      // Batch runs end after a fixed amount of game time
+      if ( g_CVar_eng_timelimit.getFloat() > 0.0f
+        && fTime >= (GameTime)g_CVar_eng_timelimit.getFloat() )
+        signalStop();
+
+      // Leftover time blends visuals between the last two logic steps
+      fTimeAlpha = std::min( fTimeAccumulator / fLogicStep, 1.0 );
+
+      // Use up any slack on deferred work
+      mGovernor->drainDeferred();
+      mFrameStats->lap( FrameSection_Deferred );
+
       // Run scene draw & entity visualize
       mGame->componentPostUpdate( fTimeDelta, fTime );
-      mEntities->componentPostUpdate( fTimeDelta, fTime );
+      if ( !mHeadless )
+        mEntities->componentPostUpdate( fTimeDelta, fTime );
+      mFrameStats->lap( FrameSection_PostUpdate );
 
       // If any time has passed, draw
-      if ( fTimeDelta > 0.0 && mSignal != Signal_Stop ) {
+      if ( fTimeDelta > 0.0 && mSignal != Signal_Stop && mGraphics ) {
         mGraphics->componentPostUpdate( fTimeDelta, fTime );
       }
+      mFrameStats->lap( FrameSection_Render );
+
+      mFrameStats->endFrame( fTime );
 
     }
+
+    QueryPerformanceCounter( &timeNew );
+    mConsole->printf( Console::srcEngine,
+      L"Simulated %.2fs of game time in %.2fs",
+      fTime, (GameTime)( timeNew.QuadPart - timeStart.QuadPart ) / (GameTime)mHPCFrequency.QuadPart );
   }
 
   void Engine::callbackVersion( Console* console, ConCmd* command,
@@ -329,6 +472,8 @@ namespace Glacier {
       (float)Locator::getMemory().getMemoryUsage( Memory::Sector_Audio ) / 1048576.0f );
     console->printf( Console::srcEngine, L"Navigation usage: %.2fMB",
       (float)Locator::getMemory().getMemoryUsage( Memory::Sector_Navigation ) / 1048576.0f );
+    console->printf( Console::srcEngine, L"Entities usage: %.2fMB",
+      (float)Locator::getMemory().getMemoryUsage( Memory::Sector_Entities ) / 1048576.0f );
   }
 
   void Engine::callbackScreenshot( Console* console, ConCmd* command,
@@ -339,7 +484,8 @@ namespace Glacier {
 
     // TODO:LOW maybe pause execution and timing,
     // since this can cause a tiny hiccup
-    gEngine->getGraphics()->screenshot();
+    if ( gEngine->getGraphics() )
+      gEngine->getGraphics()->screenshot();
   }
 
   void Engine::callbackQuit( Console* console, ConCmd* command,
@@ -373,13 +519,26 @@ namespace Glacier {
     }
 
     SAFE_DELETE( mInput );
+    SAFE_DELETE( mFrameStats );
+    SAFE_DELETE( mGovernor );
+    SAFE_DELETE( mScheduler );
+    SAFE_DELETE( mJobs );
+    SAFE_DELETE( mPlacement );
     SAFE_DELETE( mScripting );
+    if ( mHeadlessRoot )
+    {
+      Scripting::unregisterResources( ResourceGroupManager::getSingleton() );
+      unregisterUserLocations( ResourceGroupManager::getSingleton() );
+      SAFE_DELETE( mHeadlessRoot );
+    }
     SAFE_DELETE( mGraphics );
     Locator::provideGraphics( nullptr );
     SAFE_DELETE( mWindowHandler );
     SAFE_DELETE( mConsoleWindow );
     SAFE_DELETE( mConsole );
 
+    Profiler::shutdown();
+
     SAFE_CLOSE_HANDLE( mThread );
     SAFE_CLOSE_HANDLE( mProcess );
   }
@@ -6,6 +6,7 @@
 #include "JSNatives.h"
 #include "World.h"
 #include "Scripting.h"
+#include "TransformStore.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -13,10 +14,15 @@
 namespace Glacier {
 
   Entity::Entity( World* world, const EntityBaseData* baseData ):
-  mBaseData( baseData ), mWorld( world ), mPosition( Vector3::ZERO ),
-  mOrientation( Quaternion::IDENTITY ), mNode( nullptr ),
-  mScriptable( nullptr )
+  mBaseData( baseData ), mWorld( world ), mNode( nullptr ),
+  mTransform( 0 ), mVisualizes( false ), mThreadedThink( false ),
+  mScriptable( nullptr ), mRemoval( false ), mPool( nullptr ),
+  mThinkerIndex( cInvalidEntityIndex ), mThinkInterval( 1 ), mSleeping( false ),
+  mWakeDelay( 0 ), mThinkTicket( 0 ), mScheduleDirty( false ),
+  mClassIndex( cInvalidEntityIndex )
   {
+    mWorld->getTransforms()->allocate( &mTransform );
+
     auto isolate = mWorld->getScripting()->getIsolate();
     v8::HandleScope handleScope( isolate );
 
@@ -27,12 +33,118 @@ namespace Glacier {
 
   void Entity::spawn( const Vector3& position, const Quaternion& orientation )
   {
-    mPosition = position;
-    mOrientation = orientation;
+    setPosition( position );
+    setOrientation( orientation );
+    storeTransform();
+
+    // Headless entities live on their transforms alone
+    if ( !Locator::hasGraphics() )
+      return;
 
     auto scm = Locator::getGraphics().getScene();
-    mNode = scm->getRootSceneNode()->createChildSceneNode( Ogre::SCENE_DYNAMIC, mPosition, mOrientation );
+    mNode = scm->getRootSceneNode()->createChildSceneNode( Ogre::SCENE_DYNAMIC, position, orientation );
     mNode->setDirection( Vector3::NEGATIVE_UNIT_Z, Ogre::Node::TS_WORLD );
+    mWorld->getTransforms()->setNode( mTransform, mNode,
+      TransformStore::Flag_SyncPosition | TransformStore::Flag_SyncOrientation );
+  }
+
+  void Entity::storeTransform()
+  {
+    mWorld->getTransforms()->storePrevious( mTransform );
+  }
+
+  const Vector3 Entity::getPosition() const throw( )
+  {
+    return mWorld->getTransforms()->getPosition( mTransform );
+  }
+
+  const Quaternion Entity::getOrientation() const throw( )
+  {
+    return mWorld->getTransforms()->getOrientation( mTransform );
+  }
+
+  void Entity::setPosition( const Vector3& position )
+  {
+    mWorld->getTransforms()->setPosition( mTransform, position );
+  }
+
+  void Entity::setOrientation( const Quaternion& orientation )
+  {
+    mWorld->getTransforms()->setOrientation( mTransform, orientation );
+  }
+
+  const Vector3 Entity::getInterpolatedPosition( const GameTime alpha ) const
+  {
+    return mWorld->getTransforms()->getInterpolatedPosition( mTransform, alpha );
+  }
+
+  const Quaternion Entity::getInterpolatedOrientation( const GameTime alpha ) const
+  {
+    return mWorld->getTransforms()->getInterpolatedOrientation( mTransform, alpha );
+  }
+
+  const bool Entity::hasTag( const EntityTag tag ) const
+  {
+    for ( auto& slot : mTagSlots )
+      if ( slot.tag == tag )
+        return true;
+
+    return false;
+  }
+
+  void Entity::setThinkInterval( const uint32_t steps )
+  {
+    mThinkInterval = steps;
+    mWorld->getEntities()->reschedule( this );
+  }
+
+  void Entity::sleep()
+  {
+    mSleeping = true;
+    mWakeDelay = 0;
+    mWorld->getEntities()->reschedule( this );
+  }
+
+  void Entity::wakeAfter( const uint32_t steps )
+  {
+    mSleeping = true;
+    mWakeDelay = std::max( steps, (uint32_t)1 );
+    mWorld->getEntities()->reschedule( this );
+  }
+
+  void Entity::wake()
+  {
+    if ( !mSleeping )
+      return;
+
+    mSleeping = false;
+    mWakeDelay = 0;
+    mWorld->getEntities()->reschedule( this );
+  }
+
+  void Entity::configure( const void* parameters )
+  {
+    //
+  }
+
+  physx::PxRigidActor* Entity::getActor()
+  {
+    return nullptr;
+  }
+
+  void Entity::prethink( const GameTime delta )
+  {
+    //
+  }
+
+  void Entity::postthink( const GameTime delta )
+  {
+    //
+  }
+
+  void Entity::visualize( const GameTime alpha )
+  {
+    //
   }
 
   void Entity::remove()
@@ -42,6 +154,7 @@ namespace Glacier {
 
   Entity::~Entity()
   {
+    mWorld->getTransforms()->release( mTransform );
     SAFE_DELETE( mScriptable );
     if ( mNode )
     {
@@ -4,26 +4,92 @@
 #include "EntityManager.h"
 #include "EntityRegistry.h"
 #include "Entity.h"
+#include "EntityPool.h"
 #include "World.h"
+#include "PhysicsScene.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "TransformStore.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
 
 namespace Glacier {
 
+  ENGINE_DECLARE_CONVAR( ai_tickrate,
+    L"Entity prethink (AI) rate in Hz. 0 = every logic step.", 20 );
+  ENGINE_DECLARE_CONVAR( ent_parallelthink,
+    L"Run threaded entity thinkers in parallel on the job system.", true );
+  ENGINE_DECLARE_CONVAR( ent_thinkbatch,
+    L"Number of entities per parallel think job.", 32 );
+  ENGINE_DECLARE_CONVAR( ent_poolchunk,
+    L"Number of entities to allocate memory for at once when a class pool grows.", 32 );
+  ENGINE_DECLARE_CONCMD( ent_think,
+    L"Print entity think scheduling statistics.", EntityManager::callbackThink );
+  ENGINE_DECLARE_CONCMD( ent_pools,
+    L"Print entity pool statistics.", EntityManager::callbackPools );
+  ENGINE_DECLARE_CONCMD( ent_reserve,
+    L"Preallocate memory for entities of a class. Format: ent_reserve <class> <count>",
+    EntityManager::callbackReserve );
+
+  const EntityVector EntityManager::cNoEntities;
+
   EntityManager::EntityManager( Engine* engine, World* world ):
   EngineComponent( engine ),
-  mNamingCounter( 0 ), mWorld( world )
+  mNamingCounter( 0 ), mWorld( world ), mFreeSlot( cInvalidEntityIndex ),
+  mDeferring( false ), mThinkDelta( 0.0 ), mStep( 0 )
   {
     //
   }
 
-  string EntityManager::nextEntityName()
+  EntityHandle EntityManager::allocate( Entity* entity )
+  {
+    uint32_t index;
+    if ( mFreeSlot != cInvalidEntityIndex )
+    {
+      index = mFreeSlot;
+      mFreeSlot = mSlots[index].next;
+    }
+    else
+    {
+      index = (uint32_t)mSlots.size();
+      Slot slot = { nullptr, 1, cInvalidEntityIndex };
+      mSlots.push_back( slot );
+    }
+
+    auto& slot = mSlots[index];
+    slot.entity = entity;
+    slot.next = (uint32_t)mEntities.size();
+    mEntities.push_back( entity );
+
+    return EntityHandle( index, slot.generation );
+  }
+
+  void EntityManager::release( const EntityHandle handle )
+  {
+    auto& slot = mSlots[handle.index];
+
+    // Swap the last entity into the hole
+    auto last = mEntities.back();
+    mEntities[slot.next] = last;
+    mSlots[last->mHandle.index].next = slot.next;
+    mEntities.pop_back();
+
+    // Invalidate outstanding handles, generation zero is reserved for null
+    slot.entity = nullptr;
+    if ( ++slot.generation == 0 )
+      slot.generation = 1;
+    slot.next = mFreeSlot;
+    mFreeSlot = handle.index;
+  }
+
+  Entity* EntityManager::get( const EntityHandle handle )
   {
-    char name[64];
-    sprintf_s( name, 64, "entity_%I64u", mNamingCounter );
-    mNamingCounter++;
-    return name;
+    if ( handle.index >= mSlots.size() )
+      return nullptr;
+
+    auto& slot = mSlots[handle.index];
+    return ( slot.generation == handle.generation ? slot.entity : nullptr );
   }
 
   Entity* EntityManager::create( const string& className, const string& name )
@@ -35,18 +101,148 @@ namespace Glacier {
     if ( findByName( name ) )
       ENGINE_EXCEPT( "Cannot create entity, name is already in use" );
 
-    auto entity = record->factory( mWorld );
+    return construct( record, name );
+  }
+
+  Entity* EntityManager::construct( const EntityRecord* record, const string& name )
+  {
+    auto pool = getPool( record );
+    auto block = pool->acquire();
+
+    Entity* entity;
+    try
+    {
+      entity = record->factory( mWorld, block );
+    }
+    catch ( ... )
+    {
+      pool->recycle( block );
+      throw;
+    }
+
+    entity->mPool = pool;
     entity->setName( name );
-    mEntities.push_back( entity );
+    entity->mHandle = allocate( entity );
+    entity->mScriptable->setHandle( entity->mHandle );
 
-    addThinker( entity );
+    index( entity );
+    applySchedule( entity );
 
     return entity;
   }
 
+  const string& EntityManager::nextAnonymousName()
+  {
+    // Generated names are short enough to stay in the strings' local
+    // buffers, and skip any names already taken explicitly
+    char name[32];
+    do
+    {
+      sprintf_s( name, 32, "entity_%I64u", mNamingCounter );
+      mNamingCounter++;
+      mAnonymousName.assign( name );
+    } while ( findByName( mAnonymousName ) );
+
+    return mAnonymousName;
+  }
+
   Entity* EntityManager::create( const string& className )
   {
-    return create( className, nextEntityName() );
+    return create( className, nextAnonymousName() );
+  }
+
+  void EntityManager::createBatch( const EntitySpawn* spawns, size_t count,
+  EntityVector& created )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    // Resolve classes up front, batches are usually runs of the same class
+    vector<const EntityRecord*> records( count );
+    std::unordered_map<const EntityRecord*, size_t> classCounts;
+    const EntityRecord* record = nullptr;
+    for ( size_t i = 0; i < count; i++ )
+    {
+      if ( !record || record->name != spawns[i].className )
+      {
+        record = EntityRegistry::instance().lookup( spawns[i].className );
+        if ( !record )
+          ENGINE_EXCEPT( "Cannot create entity batch, unknown class" );
+      }
+      records[i] = record;
+      classCounts[record]++;
+    }
+
+    // Reserve all storage once
+    mSlots.reserve( mSlots.size() + count );
+    mEntities.reserve( mEntities.size() + count );
+    mThinkers.reserve( mThinkers.size() + count );
+    mNames.reserve( mNames.size() + count );
+    mWorld->getTransforms()->reserve( mWorld->getTransforms()->size() + count );
+    for ( auto& classCount : classCounts )
+    {
+      auto pool = getPool( classCount.first );
+      pool->reserve( pool->getUsed() + classCount.second );
+      // Keyed by the in-game name, like the index, not the code class name
+      StringKey className = { &classCount.first->name };
+      auto& members = mClasses[className];
+      members.reserve( members.size() + classCount.second );
+    }
+    created.reserve( created.size() + count );
+
+    for ( size_t i = 0; i < count; i++ )
+      created.push_back( construct( records[i], nextAnonymousName() ) );
+  }
+
+  void EntityManager::spawnBatch( const EntitySpawn* spawns, size_t count,
+  EntityVector* spawned )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    EntityVector entities;
+    createBatch( spawns, count, entities );
+
+    // Physics actors created by the spawns go into the scene in one call
+    auto scene = mWorld->getPhysics();
+    scene->beginActorBatch();
+    try
+    {
+      for ( size_t i = 0; i < count; i++ )
+      {
+        entities[i]->configure( spawns[i].parameters );
+        entities[i]->spawn( spawns[i].position, spawns[i].orientation );
+      }
+    }
+    catch ( ... )
+    {
+      scene->endActorBatch();
+      throw;
+    }
+    scene->endActorBatch();
+
+    if ( spawned )
+      spawned->insert( spawned->end(), entities.begin(), entities.end() );
+  }
+
+  EntityPool* EntityManager::getPool( const EntityRecord* record )
+  {
+    auto it = mPools.find( record );
+    if ( it != mPools.end() )
+      return it->second;
+
+    auto pool = new EntityPool( record->size,
+      (size_t)std::max( g_CVar_ent_poolchunk.getInt(), 1 ) );
+    mPools[record] = pool;
+
+    return pool;
+  }
+
+  void EntityManager::reserve( const string& className, size_t count )
+  {
+    auto record = EntityRegistry::instance().lookup( className );
+    if ( !record )
+      ENGINE_EXCEPT( "Cannot reserve entities, unknown class" );
+
+    getPool( record )->reserve( count );
   }
 
   void EntityManager::componentPreUpdate( GameTime time )
@@ -54,46 +250,438 @@ namespace Glacier {
     //
   }
 
+  void EntityManager::beginStep()
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    // Move entities whose think schedule changed, then pick up
+    // the ones due on the timing wheel, so prethink sees them too
+    applySchedules();
+    advanceWheel();
+  }
+
+  void EntityManager::prethink( GameTime tick, GameTime time )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    // Run entity prethink functions, physics may be simulating meanwhile
+    // Entities created meanwhile are appended & run on the same pass
+    // Only entities thinking on this step prethink
+    for ( size_t i = 0; i < getStepThinkerCount(); i++ )
+    {
+      auto entity = getStepThinker( i );
+      if ( !entity->isRemoval() && !entity->mSleeping )
+        entity->prethink( tick );
+    }
+  }
+
   void EntityManager::componentTick( GameTime tick, GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
+    // Current transforms become the previous ones for interpolation,
+    // then pick up the simulated poses. The active transforms may point
+    // at actors removed since the fetch, so this goes before removals
+    mWorld->getTransforms()->storePrevious();
+    mWorld->getTransforms()->readPhysics( mWorld->getPhysics()->getActiveTransforms() );
     // Remove entities that have been marked for removal
     removeMarked();
-    // Run entity think functions
-    for ( auto entity : mThinkers )
-      entity->think( tick );
+
+    auto jobs = mEngine->getJobs();
+    auto batch = (size_t)std::max( g_CVar_ent_thinkbatch.getInt(), 1 );
+    size_t count;
+    mThinkDelta = tick;
+
+    if ( jobs && g_CVar_ent_parallelthink.getBool() && getStepThinkerCount() > batch )
+    {
+      if ( mCommandBuffers.size() != jobs->getThreadCount() )
+        mCommandBuffers.resize( jobs->getThreadCount() );
+
+      // Run threaded think functions in parallel, entities spawned
+      // meanwhile are created at the sync point and think next step
+      count = getStepThinkerCount();
+      mDeferring = true;
+      mWorld->getTransforms()->beginDeferring( jobs->getThreadCount() );
+      jobs->wait( jobs->parallelFor( jobs->getStepJob(), count, batch, thinkRange, this ) );
+      mWorld->getTransforms()->endDeferring();
+      mDeferring = false;
+
+      // Sync point
+      applyDeferred();
+
+      // Run the rest serially
+      for ( size_t i = 0; i < count; i++ )
+      {
+        auto entity = getStepThinker( i );
+        if ( !entity->mThreadedThink && !entity->mSleeping )
+          entity->think( mThinkDelta * (GameTime)entity->mThinkInterval );
+      }
+    }
+    else
+    {
+      // Run entity think functions
+      // Entities created meanwhile are appended & run on the same pass
+      for ( size_t i = 0; i < getStepThinkerCount(); i++ )
+      {
+        auto entity = getStepThinker( i );
+        if ( !entity->mSleeping )
+          entity->think( mThinkDelta * (GameTime)entity->mThinkInterval );
+      }
+      count = getStepThinkerCount();
+    }
+
+    // Run entity postthink functions, these may touch the physics scene
+    for ( size_t i = 0; i < count; i++ )
+    {
+      auto entity = getStepThinker( i );
+      if ( !entity->mSleeping )
+        entity->postthink( mThinkDelta * (GameTime)entity->mThinkInterval );
+    }
+
+    mDue.clear();
+    mStep++;
+  }
+
+  void EntityManager::thinkRange( size_t begin, size_t end, void* context )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    auto manager = (EntityManager*)context;
+    for ( size_t i = begin; i < end; i++ )
+    {
+      auto entity = manager->getStepThinker( i );
+      if ( entity->mThreadedThink && !entity->mSleeping )
+        entity->think( manager->mThinkDelta * (GameTime)entity->mThinkInterval );
+    }
+  }
+
+  void EntityManager::reschedule( Entity* entity )
+  {
+    if ( entity->mHandle.isNull() || entity->mScheduleDirty )
+      return;
+
+    entity->mScheduleDirty = true;
+
+    if ( mDeferring )
+    {
+      DeferredCommand command;
+      command.type = DeferredCommand::Command_Reschedule;
+      command.target = entity->mHandle;
+      getCommandBuffer().push_back( command );
+    }
+    else
+      mRescheduled.push_back( entity->mHandle );
+  }
+
+  void EntityManager::applySchedules()
+  {
+    for ( auto handle : mRescheduled )
+    {
+      auto entity = get( handle );
+      if ( entity )
+        applySchedule( entity );
+    }
+    mRescheduled.clear();
+  }
+
+  void EntityManager::applySchedule( Entity* entity )
+  {
+    entity->mScheduleDirty = false;
+
+    // Invalidate any wheel entries, and leave the every step set
+    entity->mThinkTicket++;
+    removeThinker( entity );
+
+    if ( entity->mSleeping )
+    {
+      if ( entity->mWakeDelay > 0 )
+        schedule( entity, mStep + entity->mWakeDelay );
+    }
+    else if ( entity->mThinkInterval == 1 )
+      addThinker( entity );
+    else if ( entity->mThinkInterval > 1 )
+    {
+      // Start on the least loaded step within the first interval
+      auto span = std::min( entity->mThinkInterval, (uint32_t)cThinkWheelSize );
+      uint32_t offset = 1;
+      for ( uint32_t i = 2; i <= span; i++ )
+        if ( mWheel[( mStep + i ) & ( cThinkWheelSize - 1 )].size()
+          < mWheel[( mStep + offset ) & ( cThinkWheelSize - 1 )].size() )
+          offset = i;
+      schedule( entity, mStep + offset );
+    }
+  }
+
+  void EntityManager::schedule( Entity* entity, uint64_t due )
+  {
+    WheelEntry entry = { entity->mHandle, entity->mThinkTicket, due };
+    mWheel[due & ( cThinkWheelSize - 1 )].push_back( entry );
+  }
+
+  void EntityManager::advanceWheel()
+  {
+    // Entries are rescheduled into the same bucket when the interval is
+    // a multiple of the wheel size, so work off a copy
+    auto& bucket = mWheel[mStep & ( cThinkWheelSize - 1 )];
+    mWheelScratch.swap( bucket );
+
+    for ( auto& entry : mWheelScratch )
+    {
+      auto entity = get( entry.handle );
+      if ( !entity || entity->mThinkTicket != entry.ticket )
+        continue;
+
+      // Not due until a later turn of the wheel
+      if ( entry.due > mStep )
+      {
+        bucket.push_back( entry );
+        continue;
+      }
+
+      if ( entity->mSleeping )
+      {
+        // Wake timer
+        entity->mSleeping = false;
+        entity->mWakeDelay = 0;
+        applySchedule( entity );
+        if ( entity->mThinkInterval > 1 )
+          mDue.push_back( entity );
+      }
+      else
+      {
+        mDue.push_back( entity );
+        schedule( entity, entry.due + entity->mThinkInterval );
+      }
+    }
+
+    mWheelScratch.clear();
+  }
+
+  EntityManager::CommandBuffer& EntityManager::getCommandBuffer()
+  {
+    auto index = mEngine->getJobs()->getThreadIndex();
+    if ( index < 0 || (size_t)index >= mCommandBuffers.size() )
+      ENGINE_EXCEPT( "Entity command deferred from outside the job system" );
+
+    return mCommandBuffers[index];
+  }
+
+  void EntityManager::deferSpawn( const string& className,
+  const Vector3& position, const Quaternion& orientation )
+  {
+    if ( !mDeferring )
+    {
+      create( className )->spawn( position, orientation );
+      return;
+    }
+
+    DeferredCommand command;
+    command.type = DeferredCommand::Command_Spawn;
+    command.className = className;
+    command.position = position;
+    command.orientation = orientation;
+    getCommandBuffer().push_back( command );
+  }
+
+  void EntityManager::deferCall( const EntityHandle target,
+  EntityCallback callback, void* context )
+  {
+    if ( !mDeferring )
+    {
+      auto entity = get( target );
+      if ( entity )
+        callback( entity, context );
+      return;
+    }
+
+    DeferredCommand command;
+    command.type = DeferredCommand::Command_Call;
+    command.target = target;
+    command.callback = callback;
+    command.context = context;
+    getCommandBuffer().push_back( command );
+  }
+
+  void EntityManager::applyDeferred()
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    // Applied in thread order, commands from one thread keep their order
+    for ( auto& buffer : mCommandBuffers )
+    {
+      for ( auto& command : buffer )
+      {
+        switch ( command.type )
+        {
+          case DeferredCommand::Command_Spawn:
+            create( command.className )->spawn( command.position, command.orientation );
+            break;
+          case DeferredCommand::Command_Remove:
+          {
+            auto entity = get( command.target );
+            if ( entity )
+              markForRemoval( entity );
+            break;
+          }
+          case DeferredCommand::Command_Call:
+          {
+            auto entity = get( command.target );
+            if ( entity )
+              command.callback( entity, command.context );
+            break;
+          }
+          case DeferredCommand::Command_Reschedule:
+            mRescheduled.push_back( command.target );
+            break;
+        }
+      }
+      buffer.clear();
+    }
   }
 
   void EntityManager::componentPostUpdate( GameTime delta, GameTime time )
   {
-    // Run entity scene graph transforms
+    GLACIER_PROFILE_FUNCTION();
+
+    // Sync scene graph transforms, blended between logic steps,
+    // then let entities with extra visuals apply them
+    auto alpha = mEngine->getInterpolation();
+    mWorld->getTransforms()->sync( alpha );
     for ( auto entity : mEntities )
-      entity->visualize();
+      if ( entity->mVisualizes )
+        entity->visualize( alpha );
   }
 
   Entity* EntityManager::findByName( const string& name )
   {
-    for ( auto entity : mEntities )
-      if ( entity->getName() == name )
-        return entity;
+    StringKey key = { &name };
+    auto it = mNames.find( key );
+
+    return ( it != mNames.end() ? it->second : nullptr );
+  }
+
+  const EntityVector& EntityManager::findByClass( const string& className )
+  {
+    StringKey key = { &className };
+    auto it = mClasses.find( key );
+
+    return ( it != mClasses.end() ? it->second : cNoEntities );
+  }
+
+  EntityTag EntityManager::getTag( const string& name )
+  {
+    auto it = mTagNames.find( name );
+    if ( it != mTagNames.end() )
+      return it->second;
 
-    return nullptr;
+    auto tag = (EntityTag)mTags.size();
+    mTagNames[name] = tag;
+    mTags.push_back( EntityVector() );
+
+    return tag;
+  }
+
+  void EntityManager::addTag( Entity* entity, const EntityTag tag )
+  {
+    if ( tag >= mTags.size() || entity->hasTag( tag ) )
+      return;
+
+    EntityTagSlot slot = { tag, (uint32_t)mTags[tag].size() };
+    entity->mTagSlots.push_back( slot );
+    mTags[tag].push_back( entity );
+  }
+
+  void EntityManager::removeTag( Entity* entity, const EntityTag tag )
+  {
+    auto& slots = entity->mTagSlots;
+    for ( size_t i = 0; i < slots.size(); i++ )
+    {
+      if ( slots[i].tag != tag )
+        continue;
+
+      // Swap the last tagged entity into the hole
+      auto& tagged = mTags[tag];
+      auto last = tagged.back();
+      tagged[slots[i].index] = last;
+      for ( auto& lastSlot : last->mTagSlots )
+        if ( lastSlot.tag == tag )
+          lastSlot.index = slots[i].index;
+      tagged.pop_back();
+
+      slots[i] = slots.back();
+      slots.pop_back();
+      return;
+    }
+  }
+
+  const EntityVector& EntityManager::findByTag( const EntityTag tag )
+  {
+    return ( tag < mTags.size() ? mTags[tag] : cNoEntities );
+  }
+
+  void EntityManager::index( Entity* entity )
+  {
+    StringKey name = { &entity->mName };
+    mNames[name] = entity;
+
+    StringKey className = { &entity->getBaseData().className };
+    auto& members = mClasses[className];
+    entity->mClassIndex = (uint32_t)members.size();
+    members.push_back( entity );
+  }
+
+  void EntityManager::unindex( Entity* entity )
+  {
+    StringKey name = { &entity->mName };
+    mNames.erase( name );
+
+    StringKey className = { &entity->getBaseData().className };
+    auto& members = mClasses[className];
+    auto last = members.back();
+    members[entity->mClassIndex] = last;
+    last->mClassIndex = entity->mClassIndex;
+    members.pop_back();
+    entity->mClassIndex = cInvalidEntityIndex;
+
+    while ( !entity->mTagSlots.empty() )
+      removeTag( entity, entity->mTagSlots.back().tag );
   }
 
   void EntityManager::addThinker( Entity* entity )
   {
+    if ( entity->mThinkerIndex != cInvalidEntityIndex )
+      return;
+
+    entity->mThinkerIndex = (uint32_t)mThinkers.size();
     mThinkers.push_back( entity );
   }
 
   void EntityManager::removeThinker( Entity* entity )
   {
-    mThinkers.remove( entity );
+    if ( entity->mThinkerIndex == cInvalidEntityIndex )
+      return;
+
+    auto last = mThinkers.back();
+    mThinkers[entity->mThinkerIndex] = last;
+    last->mThinkerIndex = entity->mThinkerIndex;
+    mThinkers.pop_back();
+    entity->mThinkerIndex = cInvalidEntityIndex;
   }
 
   void EntityManager::remove( Entity* entity )
   {
     removeThinker( entity );
-    mEntities.remove( entity );
-    delete entity;
+    // Only between beginStep & the end of the step
+    if ( !mDue.empty() )
+      mDue.erase( std::remove( mDue.begin(), mDue.end(), entity ), mDue.end() );
+    unindex( entity );
+    release( entity->mHandle );
+
+    // The pool block starts at the most derived object
+    auto pool = entity->mPool;
+    auto block = dynamic_cast<void*>( entity );
+    entity->~Entity();
+    pool->recycle( block );
   }
 
   void EntityManager::remove( const string& name )
@@ -105,32 +693,135 @@ namespace Glacier {
 
   void EntityManager::markForRemoval( Entity* entity )
   {
+    if ( mDeferring )
+    {
+      DeferredCommand command;
+      command.type = DeferredCommand::Command_Remove;
+      command.target = entity->mHandle;
+      getCommandBuffer().push_back( command );
+      return;
+    }
+
+    if ( entity->isRemoval() )
+      return;
+
     entity->markForRemoval();
-    mRemovals.push_back( entity );
+    mRemovals.push_back( entity->mHandle );
   }
 
   void EntityManager::removeMarked()
   {
-    for ( auto entity : mRemovals )
-      remove( entity );
+    for ( auto handle : mRemovals )
+    {
+      auto entity = get( handle );
+      if ( entity )
+        remove( entity );
+    }
     mRemovals.clear();
   }
 
   void EntityManager::clear()
   {
     removeMarked();
-    for ( auto entity : mEntities )
+    // Slots are kept so that handles to cleared entities stay stale
+    while ( !mEntities.empty() )
+      remove( mEntities.back() );
+    for ( auto& bucket : mWheel )
+      bucket.clear();
+    mDue.clear();
+    mRescheduled.clear();
+    // All pools are empty now, so their chunks go in one go
+    for ( auto& pool : mPools )
+      pool.second->release();
+    mNamingCounter = 0;
+  }
+
+  void EntityManager::callbackThink( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getWorld() )
+      return;
+
+    auto manager = gEngine->getWorld()->getEntities();
+
+    size_t sleeping = 0;
+    size_t idle = 0;
+    for ( auto entity : manager->mEntities )
     {
-      removeThinker( entity );
-      delete entity;
+      if ( entity->mSleeping )
+        sleeping++;
+      else if ( entity->mThinkInterval == 0 )
+        idle++;
     }
-    mEntities.clear();
-    mNamingCounter = 0;
+
+    size_t entries = 0;
+    size_t busiest = 0;
+    for ( auto& bucket : manager->mWheel )
+    {
+      entries += bucket.size();
+      busiest = std::max( busiest, bucket.size() );
+    }
+
+    console->printf( Console::srcEngine,
+      L"Entities: %d, thinking every step: %d, sleeping: %d, never thinking: %d",
+      (int)manager->mEntities.size(), (int)manager->mThinkers.size(),
+      (int)sleeping, (int)idle );
+    console->printf( Console::srcEngine,
+      L"Timing wheel: %d entries over %d steps, busiest step %d",
+      (int)entries, (int)cThinkWheelSize, (int)busiest );
+    console->printf( Console::srcEngine,
+      L"Transforms: %d, moving: %d",
+      (int)manager->mWorld->getTransforms()->size(),
+      (int)manager->mWorld->getTransforms()->getMovingCount() );
+  }
+
+  void EntityManager::callbackPools( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getWorld() )
+      return;
+
+    auto manager = gEngine->getWorld()->getEntities();
+    for ( auto& pool : manager->mPools )
+    {
+      console->printf( Console::srcEngine,
+        L"%S: %d/%d used, %d chunks, %d bytes per entity",
+        pool.first->name.c_str(), (int)pool.second->getUsed(),
+        (int)pool.second->getCapacity(), (int)pool.second->getChunkCount(),
+        (int)pool.second->getBlockSize() );
+    }
+  }
+
+  void EntityManager::callbackReserve( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getWorld() )
+      return;
+
+    if ( arguments.size() != 3 )
+    {
+      console->errorPrintf( Console::srcEngine, L"Format: ent_reserve <class> <count>" );
+      return;
+    }
+
+    auto className = Utilities::wideToUtf8( arguments[1] );
+    auto count = _wtoi( arguments[2].c_str() );
+    if ( count <= 0 || !EntityRegistry::instance().lookup( className ) )
+    {
+      console->errorPrintf( Console::srcEngine,
+        L"Cannot reserve %s: %s", arguments[2].c_str(), arguments[1].c_str() );
+      return;
+    }
+
+    gEngine->getWorld()->getEntities()->reserve( className, (size_t)count );
   }
 
   EntityManager::~EntityManager()
   {
     clear();
+    for ( auto& pool : mPools )
+      delete pool.second;
+    mPools.clear();
   }
 
 }
\ No newline at end of file
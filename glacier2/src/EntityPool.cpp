@@ -0,0 +1,84 @@
+#include "StdAfx.h"
+#include "EntityPool.h"
+#include "Exception.h"
+#include "ServiceLocator.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  EntityPool::EntityPool( size_t objectSize, size_t chunkSize ):
+  mChunkSize( std::max( chunkSize, (size_t)1 ) ), mFree( nullptr ),
+  mCapacity( 0 ), mUsed( 0 )
+  {
+    // Free blocks store the next pointer in place
+    mBlockSize = std::max( objectSize, sizeof( void* ) );
+    mBlockSize = ( mBlockSize + cEntityPoolAlignment - 1 ) & ~( cEntityPoolAlignment - 1 );
+  }
+
+  void EntityPool::grow( size_t count )
+  {
+    auto chunk = (uint8_t*)Locator::getMemory().alloc( Memory::Sector_Entities,
+      mBlockSize * count, cEntityPoolAlignment );
+    if ( !chunk )
+      ENGINE_EXCEPT( "Entity pool allocation failed" );
+
+    mChunks.push_back( chunk );
+
+    // Thread the new blocks in front of the free list, lowest address first
+    for ( size_t i = count; i > 0; i-- )
+    {
+      auto block = chunk + ( i - 1 ) * mBlockSize;
+      *(void**)block = mFree;
+      mFree = block;
+    }
+
+    mCapacity += count;
+  }
+
+  void* EntityPool::acquire()
+  {
+    if ( !mFree )
+      grow( mChunkSize );
+
+    auto block = mFree;
+    mFree = *(void**)block;
+    mUsed++;
+
+    return block;
+  }
+
+  void EntityPool::recycle( void* block )
+  {
+    assert( mUsed > 0 );
+
+    *(void**)block = mFree;
+    mFree = block;
+    mUsed--;
+  }
+
+  void EntityPool::reserve( size_t count )
+  {
+    if ( count > mCapacity )
+      grow( count - mCapacity );
+  }
+
+  void EntityPool::release()
+  {
+    assert( mUsed == 0 );
+
+    for ( auto chunk : mChunks )
+      Locator::getMemory().free( Memory::Sector_Entities, chunk );
+
+    mChunks.clear();
+    mFree = nullptr;
+    mCapacity = 0;
+  }
+
+  EntityPool::~EntityPool()
+  {
+    release();
+  }
+
+}
\ No newline at end of file
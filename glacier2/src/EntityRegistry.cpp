@@ -11,12 +11,12 @@
 namespace Glacier {
 
   void EntityRegistry::declare( const string& name, const string& className,
-  fnEntityFactory factory )
+  size_t size, fnEntityFactory factory )
   {
-    assert( !name.empty() && factory );
+    assert( !name.empty() && size && factory );
     assert( mRecords.find( name ) == mRecords.end() );
 
-    auto record = new EntityRecord( name, className, factory );
+    auto record = new EntityRecord( name, className, size, factory );
     mRecords[name] = record;
   }
 
@@ -5,6 +5,7 @@
 #include "Exception.h"
 #include "ServiceLocator.h"
 #include "FMODMusic.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -31,6 +32,8 @@ namespace Glacier {
   ENGINE_DECLARE_CONVAR_WITH_CB( fm_outputmode,
     L"Audio output mode. Valid values are \"nosound\" (No output),\"auto\" (System default),\"winmm\" (Windows MultiMedia),\"dsound\" (DirectSound),\"wasapi\" (WASAPI),\"asio\" (ASIO 2.0).",
     L"auto", FMODAudio::callbackOutputMode );
+  ENGINE_DECLARE_CONVAR( fm_tickrate,
+    L"Sound engine update rate in Hz. 0 = every logic step.", 30 );
   ENGINE_DECLARE_CONCMD( fm_restart,
     L"Restart the sound subsystem to apply changes to speaker/output setup.",
     FMODAudio::callbackAudioRestart );
@@ -289,6 +292,8 @@ namespace Glacier {
 
   void FMODAudio::componentTick( GameTime tick, GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     mMusic->update( tick );
     mEventSystem->update();
   }
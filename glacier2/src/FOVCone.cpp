@@ -12,12 +12,18 @@ namespace Glacier {
 
   FOVCone::FOVCone(): item( nullptr ), node( nullptr ), alert( false )
   {
+    if ( !Locator::hasGraphics() )
+      return;
+
     auto scene = Locator::getGraphics().getScene();
     node = scene->createSceneNode();
   }
 
   FOVCone::~FOVCone()
   {
+    if ( !node )
+      return;
+
     auto scene = Locator::getGraphics().getScene();
 
     if ( item )
@@ -44,6 +50,9 @@ namespace Glacier {
     Real halfFov = Degree( fieldOfView.valueDegrees() / 2.0f ).valueRadians();
     Real viewRadius = ( viewDistance * tanf( halfFov ) );
 
+    if ( !node )
+      return;
+
     auto scene = Locator::getGraphics().getScene();
     node->detachAllObjects();
 
@@ -0,0 +1,143 @@
+#include "StdAfx.h"
+#include "FrameGovernor.h"
+#include "Engine.h"
+#include "Console.h"
+#include "Profiler.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  ENGINE_DECLARE_CONVAR( eng_maxsteps,
+    L"Maximum number of catch-up logic steps per frame. Excess time is dropped.", 5 );
+  ENGINE_DECLARE_CONVAR( eng_framebudget,
+    L"Frame CPU budget in milliseconds for logic steps and deferred work.", 12.0f );
+  ENGINE_DECLARE_CONCMD( eng_governor,
+    L"Print frame governor statistics.", FrameGovernor::callbackStats );
+
+  FrameGovernor::FrameGovernor( Engine* engine ): mEngine( engine )
+  {
+    QueryPerformanceFrequency( &mFrequency );
+    QueryPerformanceCounter( &mFrameStart );
+    memset( &mStats, 0, sizeof( mStats ) );
+  }
+
+  void FrameGovernor::beginFrame()
+  {
+    QueryPerformanceCounter( &mFrameStart );
+
+    // Posting threads stamp work with the frame number under the same lock
+    ScopedRWLock lock( &mLock );
+    mStats.frames++;
+  }
+
+  GameTime FrameGovernor::getFrameTime()
+  {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter( &now );
+    return (GameTime)( now.QuadPart - mFrameStart.QuadPart ) / (GameTime)mFrequency.QuadPart;
+  }
+
+  bool FrameGovernor::isOverBudget()
+  {
+    return ( getFrameTime() * 1000.0 >= (GameTime)g_CVar_eng_framebudget.getFloat() );
+  }
+
+  GameTime FrameGovernor::limitCatchUp( GameTime accumulator, GameTime step )
+  {
+    auto maxSteps = std::max( g_CVar_eng_maxsteps.getInt(), 1 );
+    auto limit = step * (GameTime)maxSteps;
+    if ( accumulator < limit + step )
+      return accumulator;
+
+    // Keep the sub-step remainder so interpolation stays continuous
+    auto dropped = (uint64_t)( ( accumulator - limit ) / step );
+    mStats.stepsDropped += dropped;
+    mStats.timeDropped += (GameTime)dropped * step;
+
+    return accumulator - (GameTime)dropped * step;
+  }
+
+  bool FrameGovernor::post( DeferredFunction function, void* context )
+  {
+    ScopedRWLock lock( &mLock );
+
+    if ( mDeferred.size() >= cMaxDeferredWork )
+    {
+      mStats.rejected++;
+      return false;
+    }
+
+    DeferredWork work = { function, context, mStats.frames };
+    mDeferred.push_back( work );
+    mStats.posted++;
+
+    return true;
+  }
+
+  void FrameGovernor::drainDeferred()
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    bool overBudget = isOverBudget();
+    if ( overBudget )
+      mStats.overBudget++;
+
+    while ( true )
+    {
+      ScopedRWLock lock( &mLock );
+      if ( mDeferred.empty() )
+        break;
+
+      auto work = mDeferred.front();
+      bool starving = ( mStats.frames - work.frame >= cMaxDeferralFrames );
+      if ( overBudget && !starving )
+      {
+        mStats.carried++;
+        break;
+      }
+
+      mDeferred.pop_front();
+      lock.unlock();
+
+      work.function( work.context );
+
+      mStats.executed++;
+      if ( overBudget )
+        mStats.forced++;
+
+      overBudget = isOverBudget();
+    }
+  }
+
+  void FrameGovernor::callbackStats( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getGovernor() )
+      return;
+
+    auto governor = gEngine->getGovernor();
+    auto& stats = governor->mStats;
+
+    size_t pending = 0;
+    {
+      ScopedRWLock lock( &governor->mLock, false );
+      pending = governor->mDeferred.size();
+    }
+
+    console->printf( Console::srcEngine,
+      L"Frames: %I64u, over budget: %I64u",
+      stats.frames, stats.overBudget );
+    console->printf( Console::srcEngine,
+      L"Dropped steps: %I64u (%.3fs of game time)",
+      stats.stepsDropped, stats.timeDropped );
+    console->printf( Console::srcEngine,
+      L"Deferred work: %I64u posted, %I64u executed (%I64u forced), %I64u rejected, %d pending",
+      stats.posted, stats.executed, stats.forced, stats.rejected, (int)pending );
+    console->printf( Console::srcEngine,
+      L"Frames carrying deferred work over: %I64u",
+      stats.carried );
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "StdAfx.h"
+#include "FrameStatistics.h"
+#include "Engine.h"
+#include "Console.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  const wchar_t* cFrameStatisticsDefaultExport = L"frames.csv";
+
+  const char* cFrameSectionNames[FrameSection_Count] = {
+    "preupdate", "physics", "input", "game", "ai",
+    "audio", "entities", "deferred", "postupdate", "render"
+  };
+
+  ENGINE_DECLARE_CONVAR( stat_window,
+    L"Number of most recent frames and logic steps in frame time percentiles.", 300 );
+  ENGINE_DECLARE_CONVAR( stat_hitchms,
+    L"Frame time in milliseconds above which a frame is reported as a hitch. 0 disables.", 50.0f );
+  ENGINE_DECLARE_CONCMD( stat_frames,
+    L"Print frame & logic step time percentiles and recent hitches.",
+    FrameStatistics::callbackFrames );
+  ENGINE_DECLARE_CONCMD( stat_export,
+    L"Write the frame time history to a CSV file. Format: stat_export [filename]",
+    FrameStatistics::callbackExport );
+
+  FrameStatistics::FrameStatistics( Engine* engine ): mEngine( engine ),
+  mFrameCount( 0 ), mStepCount( 0 ), mHitchCount( 0 )
+  {
+    QueryPerformanceFrequency( &mFrequency );
+    QueryPerformanceCounter( &mFrameStart );
+    mLapStart = mFrameStart;
+    mStepStart = mFrameStart;
+    memset( &mCurrent, 0, sizeof( mCurrent ) );
+    memset( mFrames, 0, sizeof( mFrames ) );
+    memset( mSteps, 0, sizeof( mSteps ) );
+    memset( mHitches, 0, sizeof( mHitches ) );
+  }
+
+  float FrameStatistics::elapsed( LARGE_INTEGER& since, const LARGE_INTEGER& now )
+  {
+    return (float)( (double)( now.QuadPart - since.QuadPart ) * 1000.0
+      / (double)mFrequency.QuadPart );
+  }
+
+  void FrameStatistics::beginFrame()
+  {
+    QueryPerformanceCounter( &mFrameStart );
+    mLapStart = mFrameStart;
+    memset( &mCurrent, 0, sizeof( mCurrent ) );
+  }
+
+  void FrameStatistics::lap( FrameSection section )
+  {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter( &now );
+    mCurrent.sections[section] += elapsed( mLapStart, now );
+    mLapStart = now;
+  }
+
+  void FrameStatistics::beginStep()
+  {
+    QueryPerformanceCounter( &mStepStart );
+  }
+
+  void FrameStatistics::endStep()
+  {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter( &now );
+    mSteps[mStepCount & ( cFrameHistorySize - 1 )] = elapsed( mStepStart, now );
+    mStepCount++;
+    mCurrent.steps++;
+  }
+
+  void FrameStatistics::endFrame( GameTime time )
+  {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter( &now );
+    mCurrent.frame = elapsed( mFrameStart, now );
+    mFrames[mFrameCount & ( cFrameHistorySize - 1 )] = mCurrent;
+    mFrameCount++;
+
+    auto threshold = g_CVar_stat_hitchms.getFloat();
+    if ( threshold <= 0.0f || mCurrent.frame < threshold )
+      return;
+
+    auto& hitch = mHitches[mHitchCount % cMaxHitchReports];
+    hitch.frame = mFrameCount;
+    hitch.time = time;
+    hitch.duration = mCurrent.frame;
+    hitch.worst = FrameSection_PreUpdate;
+    hitch.worstDuration = mCurrent.sections[0];
+    for ( int i = 1; i < FrameSection_Count; i++ )
+    {
+      if ( mCurrent.sections[i] > hitch.worstDuration )
+      {
+        hitch.worst = (FrameSection)i;
+        hitch.worstDuration = mCurrent.sections[i];
+      }
+    }
+    mHitchCount++;
+
+    mEngine->getConsole()->printf( Console::srcEngine,
+      L"Hitch: frame %I64u took %.2fms (%d steps), longest was %S at %.2fms",
+      hitch.frame, hitch.duration, mCurrent.steps,
+      cFrameSectionNames[hitch.worst], hitch.worstDuration );
+  }
+
+  FrameStatistics::Percentiles FrameStatistics::calculate( vector<float>& samples )
+  {
+    Percentiles result = { samples.size(), 0.0f, 0.0f, 0.0f, 0.0f };
+    if ( samples.empty() )
+      return result;
+
+    auto rank = [&samples]( float fraction ) -> float
+    {
+      auto nth = samples.begin() + (size_t)( fraction * (float)( samples.size() - 1 ) );
+      std::nth_element( samples.begin(), nth, samples.end() );
+      return *nth;
+    };
+
+    result.p50 = rank( 0.50f );
+    result.p95 = rank( 0.95f );
+    result.p99 = rank( 0.99f );
+    result.max = *std::max_element( samples.begin(), samples.end() );
+
+    return result;
+  }
+
+  FrameStatistics::Percentiles FrameStatistics::getFramePercentiles()
+  {
+    auto window = (uint64_t)std::max( g_CVar_stat_window.getInt(), 1 );
+    window = std::min( std::min( window, (uint64_t)cFrameHistorySize ), mFrameCount );
+
+    vector<float> samples;
+    samples.reserve( (size_t)window );
+    for ( uint64_t i = mFrameCount - window; i < mFrameCount; i++ )
+      samples.push_back( mFrames[i & ( cFrameHistorySize - 1 )].frame );
+
+    return calculate( samples );
+  }
+
+  FrameStatistics::Percentiles FrameStatistics::getStepPercentiles()
+  {
+    auto window = (uint64_t)std::max( g_CVar_stat_window.getInt(), 1 );
+    window = std::min( std::min( window, (uint64_t)cFrameHistorySize ), mStepCount );
+
+    vector<float> samples;
+    samples.reserve( (size_t)window );
+    for ( uint64_t i = mStepCount - window; i < mStepCount; i++ )
+      samples.push_back( mSteps[i & ( cFrameHistorySize - 1 )] );
+
+    return calculate( samples );
+  }
+
+  bool FrameStatistics::exportCSV( const wstring& filename )
+  {
+    string out;
+    out.reserve( cFrameHistorySize * 128 );
+    out.append( "frame,ms,steps" );
+    for ( int i = 0; i < FrameSection_Count; i++ )
+    {
+      out.push_back( ',' );
+      out.append( cFrameSectionNames[i] );
+    }
+    out.append( "\r\n" );
+
+    char buffer[64];
+    uint64_t tail = ( mFrameCount > cFrameHistorySize ? mFrameCount - cFrameHistorySize : 0 );
+    for ( uint64_t i = tail; i < mFrameCount; i++ )
+    {
+      auto& record = mFrames[i & ( cFrameHistorySize - 1 )];
+      sprintf_s( buffer, 64, "%I64u,%.3f,%u", i + 1, record.frame, record.steps );
+      out.append( buffer );
+      for ( int j = 0; j < FrameSection_Count; j++ )
+      {
+        sprintf_s( buffer, 64, ",%.3f", record.sections[j] );
+        out.append( buffer );
+      }
+      out.append( "\r\n" );
+    }
+
+    HANDLE file = CreateFileW( filename.c_str(), GENERIC_WRITE,
+      FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
+    if ( file == INVALID_HANDLE_VALUE )
+      return false;
+
+    DWORD written;
+    BOOL ret = WriteFile( file, out.c_str(), (DWORD)out.size(), &written, nullptr );
+    CloseHandle( file );
+
+    return ( ret != FALSE );
+  }
+
+  void FrameStatistics::callbackFrames( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getFrameStats() )
+      return;
+
+    auto stats = gEngine->getFrameStats();
+
+    auto frames = stats->getFramePercentiles();
+    console->printf( Console::srcEngine,
+      L"Frames (%d): p50 %.2fms, p95 %.2fms, p99 %.2fms, max %.2fms",
+      (int)frames.samples, frames.p50, frames.p95, frames.p99, frames.max );
+
+    auto steps = stats->getStepPercentiles();
+    console->printf( Console::srcEngine,
+      L"Steps (%d): p50 %.2fms, p95 %.2fms, p99 %.2fms, max %.2fms",
+      (int)steps.samples, steps.p50, steps.p95, steps.p99, steps.max );
+
+    console->printf( Console::srcEngine,
+      L"Hitches: %I64u", stats->mHitchCount );
+
+    uint64_t tail = ( stats->mHitchCount > cMaxHitchReports
+      ? stats->mHitchCount - cMaxHitchReports : 0 );
+    for ( uint64_t i = tail; i < stats->mHitchCount; i++ )
+    {
+      auto& hitch = stats->mHitches[i % cMaxHitchReports];
+      console->printf( Console::srcEngine,
+        L"  frame %I64u at %.2fs: %.2fms, longest %S at %.2fms",
+        hitch.frame, hitch.time, hitch.duration,
+        cFrameSectionNames[hitch.worst], hitch.worstDuration );
+    }
+  }
+
+  void FrameStatistics::callbackExport( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getFrameStats() )
+      return;
+
+    wstring filename = ( arguments.size() > 1 ? arguments[1] : cFrameStatisticsDefaultExport );
+
+    if ( gEngine->getFrameStats()->exportCSV( filename ) )
+      console->printf( Console::srcEngine,
+        L"Wrote frame history to %s", filename.c_str() );
+    else
+      console->errorPrintf( Console::srcEngine,
+        L"Failed to write frame history to %s", filename.c_str() );
+  }
+
+}
\ No newline at end of file
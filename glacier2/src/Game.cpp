@@ -4,12 +4,16 @@
 #include "EngineComponent.h"
 #include "ModelViewerState.h"
 #include "DemoState.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
 
 namespace Glacier {
 
+  ENGINE_DECLARE_CONVAR( g_tickrate,
+    L"Game state update rate in Hz. 0 = every logic step.", 0 );
+
   Game::Game( Engine* engine ): EngineComponent( engine )
   {
     changeState( &DemoState::instance() );
@@ -17,12 +21,16 @@ namespace Glacier {
 
   void Game::componentTick( GameTime tick, GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     if ( !mStates.empty() )
       mStates.back()->update( tick, time );
   }
 
   void Game::componentPostUpdate( GameTime delta, GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     if ( !mStates.empty() )
       mStates.back()->draw( delta, time );
   }
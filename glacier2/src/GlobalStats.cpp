@@ -4,6 +4,9 @@
 #include "Console.h"
 #include "Exception.h"
 #include "Engine.h"
+#include "FrameStatistics.h"
+#include "World.h"
+#include "PhysicsScene.h"
 #include <OgreFrameStats.h>
 
 // Glacier² Game Engine © 2014 noorus
@@ -42,14 +45,29 @@ namespace Glacier {
     if ( !mEnabled )
       return;
 
-    mNamesText->setCaption( "AvgFPS:\r\nAvgTime:" );
+    mNamesText->setCaption(
+      "AvgFPS:\r\nAvgTime:\r\nFrame p50:\r\nFrame p95:\r\nFrame p99:\r\nFrame max:\r\nStep p99:\r\nPhysics:\r\nPx wait:" );
 
     auto stats = gEngine->getGraphics()->getRoot()->getFrameStats();
+    auto frames = gEngine->getFrameStats()->getFramePercentiles();
+    auto steps = gEngine->getFrameStats()->getStepPercentiles();
 
-    static wchar_t values[64];
-    swprintf_s( values, 64,
-      L"%0.2f\r\n%0.2f",
-      stats->getAvgFps(), stats->getAvgTime() );
+    // Substeps overlap other work, so their sum is not main thread time
+    float simulation = 0.0f, blocked = 0.0f;
+    if ( gEngine->getWorld() && gEngine->getWorld()->getPhysics() )
+    {
+      auto& timings = gEngine->getWorld()->getPhysics()->getTimings();
+      for ( uint32_t i = 0; i < timings.substeps; i++ )
+        simulation += timings.substep[i];
+      blocked = timings.blocked;
+    }
+
+    static wchar_t values[256];
+    swprintf_s( values, 256,
+      L"%0.2f\r\n%0.2f\r\n%0.2f\r\n%0.2f\r\n%0.2f\r\n%0.2f\r\n%0.2f\r\n%0.2f\r\n%0.2f",
+      stats->getAvgFps(), stats->getAvgTime(),
+      frames.p50, frames.p95, frames.p99, frames.max, steps.p99,
+      simulation, blocked );
 
     mValuesText->setCaption( Ogre::UTFString( values ) );
   }
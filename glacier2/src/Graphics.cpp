@@ -6,6 +6,7 @@
 #include "WindowHandler.h"
 #include "Win32.h"
 #include "Camera.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -448,6 +449,8 @@ namespace Glacier {
 
   void Graphics::componentPreUpdate( GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     HWND windowHandle = NULL;
     mWindow->getCustomAttribute( "WINDOW", &windowHandle );
     Win32::Win32::instance().handleMessagesFor( windowHandle );
@@ -455,6 +458,8 @@ namespace Glacier {
 
   void Graphics::componentPostUpdate( GameTime delta, GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     // Update globals
     mGlobals.stats.update();
 
@@ -7,12 +7,16 @@
 #include "Mouse.h"
 #include "Keyboard.h"
 #include "Gamepad.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
 
 namespace Glacier {
 
+  ENGINE_DECLARE_CONVAR( in_tickrate,
+    L"Input device update rate in Hz. 0 = every logic step.", 0 );
+
   InputManager::InputManager( Engine* engine, HINSTANCE instance, Ogre::RenderWindow* window ):
   EngineComponent( engine ), mSystem( nullptr ), mTakingInput( false ), mLocalController( nullptr )
   {
@@ -39,6 +43,8 @@ namespace Glacier {
 
   void InputManager::componentTick( GameTime tick, GameTime time )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     mLocalController->prepare();
 
     for ( auto mouse : mMice )
@@ -4,6 +4,8 @@
 #include "JSUtil.h"
 #include "Engine.h"
 #include "Entity.h"
+#include "EntityManager.h"
+#include "ServiceLocator.h"
 #include "EntityRegistry.h"
 #include "Console.h"
 
@@ -14,8 +16,7 @@ namespace Glacier {
 
   namespace JS {
 
-    Entity::Entity( Glacier::Entity* entity ): mEntity( entity ),
-    ObjectWrapper( Wrapped_Entity )
+    Entity::Entity(): ObjectWrapper( Wrapped_Entity )
     {
       // Stubb
     }
@@ -38,8 +39,9 @@ namespace Glacier {
 
       JS_TEMPLATE_SET( tpl, "toString", jsToString );
       JS_TEMPLATE_SET( tpl, "getName", jsGetName );
+      JS_TEMPLATE_SET( tpl, "isValid", jsIsValid );
 
-      auto instance = new Entity( entity );
+      auto instance = new Entity();
       Local<v8::Object> object = tpl->GetFunction()->NewInstance();
       instance->wrap( object );
       instance->ref();
@@ -47,27 +49,52 @@ namespace Glacier {
       return instance;
     }
 
+    void Entity::setHandle( const EntityHandle handle )
+    {
+      mHandle = handle;
+    }
+
     Glacier::Entity* Entity::getEntity()
     {
-      return mEntity;
+      return Locator::getEntities().get( mHandle );
     }
 
     void Entity::jsToString( const FunctionCallbackInfo<v8::Value>& args )
     {
       Entity* ptr = unwrap( args.Holder() );
+      auto entity = ptr->getEntity();
       char result[128];
-      sprintf_s<128>( result, "Entity[%s]", ptr->getEntity()->getName().c_str() );
+      if ( entity )
+        sprintf_s<128>( result, "Entity[%s]", entity->getName().c_str() );
+      else
+        sprintf_s<128>( result, "Entity[removed]" );
       args.GetReturnValue().Set( Util::allocString( result ) );
     }
 
     void Entity::jsGetName( const FunctionCallbackInfo<v8::Value>& args )
     {
+      Isolate* isolate = args.GetIsolate();
+      HandleScope handleScope( isolate );
+
       Entity* ptr = unwrap( args.Holder() );
       auto entity = ptr->getEntity();
+      if ( !entity )
+      {
+        Util::throwException( isolate,
+          L"Entity.getName: Entity has been removed" );
+        return;
+      }
 
       args.GetReturnValue().Set( Util::allocString( entity->getName() ) );
     }
 
+    void Entity::jsIsValid( const FunctionCallbackInfo<v8::Value>& args )
+    {
+      Entity* ptr = unwrap( args.Holder() );
+
+      args.GetReturnValue().Set( ptr->getEntity() != nullptr );
+    }
+
   }
 
 }
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include "StdAfx.h"
+#include "JobSystem.h"
+#include "Engine.h"
+#include "Console.h"
+#include "Exception.h"
+#include "ServiceLocator.h"
+#include "Profiler.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  // Job system constants =====================================================
+
+  const int      cInvalidJobThread    = -1;
+  const uint32_t cJobSpinCount        = 64;
+  const char*    cJobWorkerThreadName = "Gcr2 Job Worker %u";
+
+  //! Index of the calling thread in the job system, or cInvalidJobThread.
+  thread_local int tJobThreadIndex = cInvalidJobThread;
+
+  // Job system CVars =========================================================
+
+  ENGINE_DECLARE_CONVAR( job_workers,
+    L"Number of job worker threads. 0 = one per physical core not taken by the main thread or physics. Applied on restart.", 0 );
+  ENGINE_DECLARE_CONCMD( job_stats,
+    L"Print job system statistics.", JobSystem::callbackStats );
+
+  // JobQueue class ===========================================================
+
+  JobQueue::JobQueue(): mTop( 0 ), mBottom( 0 )
+  {
+    memset( mJobs, 0, sizeof( mJobs ) );
+  }
+
+  void JobQueue::push( Job* job )
+  {
+    int64_t bottom = mBottom.load( std::memory_order_relaxed );
+    int64_t top = mTop.load( std::memory_order_acquire );
+    if ( bottom - top >= (int64_t)cMaxJobsPerThread )
+      ENGINE_EXCEPT( "Job queue overflow" );
+
+    mJobs[bottom & ( cMaxJobsPerThread - 1 )] = job;
+    mBottom.store( bottom + 1, std::memory_order_release );
+  }
+
+  Job* JobQueue::pop()
+  {
+    int64_t bottom = mBottom.load( std::memory_order_relaxed ) - 1;
+    mBottom.store( bottom, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    int64_t top = mTop.load( std::memory_order_relaxed );
+
+    if ( top > bottom )
+    {
+      // Queue was already empty
+      mBottom.store( top, std::memory_order_relaxed );
+      return nullptr;
+    }
+
+    Job* job = mJobs[bottom & ( cMaxJobsPerThread - 1 )];
+    if ( top != bottom )
+      return job;
+
+    // Last job in the queue, race against thieves for it
+    if ( !mTop.compare_exchange_strong( top, top + 1,
+      std::memory_order_seq_cst, std::memory_order_relaxed ) )
+      job = nullptr;
+
+    mBottom.store( top + 1, std::memory_order_relaxed );
+    return job;
+  }
+
+  Job* JobQueue::steal()
+  {
+    int64_t top = mTop.load( std::memory_order_acquire );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    int64_t bottom = mBottom.load( std::memory_order_acquire );
+
+    if ( top >= bottom )
+      return nullptr;
+
+    Job* job = mJobs[top & ( cMaxJobsPerThread - 1 )];
+    if ( !mTop.compare_exchange_strong( top, top + 1,
+      std::memory_order_seq_cst, std::memory_order_relaxed ) )
+      return nullptr;
+
+    return job;
+  }
+
+  size_t JobQueue::size() const
+  {
+    int64_t count = mBottom.load( std::memory_order_relaxed )
+      - mTop.load( std::memory_order_relaxed );
+    return count > 0 ? (size_t)count : 0;
+  }
+
+  // JobWorker class ==========================================================
+
+  JobWorker::JobWorker( JobSystem* system, uint32_t index ):
+  mSystem( system ), mIndex( index )
+  {
+    char name[64];
+    sprintf_s( name, 64, cJobWorkerThreadName, mIndex );
+    mName = name;
+  }
+
+  JobWorker::~JobWorker()
+  {
+    stop();
+  }
+
+  void JobWorker::onStart()
+  {
+    tJobThreadIndex = (int)mIndex;
+  }
+
+  void JobWorker::onStep()
+  {
+    Job* job = mSystem->getJob();
+    if ( job )
+      mSystem->execute( job );
+    else
+      mSystem->sleep();
+  }
+
+  void JobWorker::onPreStop()
+  {
+    //
+  }
+
+  void JobWorker::onStop()
+  {
+    tJobThreadIndex = cInvalidJobThread;
+  }
+
+  // JobSystem class ==========================================================
+
+  JobSystem::ThreadData::ThreadData(): pool( nullptr ), allocated( 0 ),
+  executed( 0 ), stolen( 0 )
+  {
+    pool = (Job*)Locator::getMemory().alloc( Memory::Sector_Generic,
+      sizeof( Job ) * cMaxJobsPerThread, __alignof( Job ) );
+    if ( !pool )
+      ENGINE_EXCEPT( "Job pool allocation failed" );
+    memset( pool, 0, sizeof( Job ) * cMaxJobsPerThread );
+  }
+
+  JobSystem::ThreadData::~ThreadData()
+  {
+    if ( pool )
+      Locator::getMemory().free( Memory::Sector_Generic, pool );
+  }
+
+  JobSystem::JobSystem( Engine* engine, uint32_t workers ):
+  mEngine( engine ), mWakeSemaphore( NULL ), mShutdownEvent( NULL ),
+  mSleeping( 0 ), mStepJob( nullptr )
+  {
+    mWakeSemaphore = CreateSemaphoreW( NULL, 0, LONG_MAX, NULL );
+    mShutdownEvent = CreateEventW( NULL, TRUE, FALSE, NULL );
+    if ( !mWakeSemaphore || !mShutdownEvent )
+      ENGINE_EXCEPT_WINAPI( "Could not create job system events" );
+
+    // The creating thread becomes job thread 0
+    tJobThreadIndex = 0;
+
+    for ( uint32_t i = 0; i <= workers; i++ )
+      mThreads.push_back( new ThreadData() );
+
+    for ( uint32_t i = 1; i <= workers; i++ )
+    {
+      auto worker = new JobWorker( this, i );
+      mWorkers.push_back( worker );
+      worker->start();
+    }
+
+    mEngine->getConsole()->printf( Console::srcEngine,
+      L"Job system running with %d worker threads", workers );
+  }
+
+  int JobSystem::getThreadIndex() const
+  {
+    return tJobThreadIndex;
+  }
+
+  JobSystem::ThreadData& JobSystem::getThreadData()
+  {
+    assert( tJobThreadIndex != cInvalidJobThread );
+    return *mThreads[tJobThreadIndex];
+  }
+
+  Job* JobSystem::createJob( JobFunction function, const void* data, size_t size )
+  {
+    assert( size <= cJobPayloadSize );
+
+    auto& thread = getThreadData();
+    Job* job = &thread.pool[thread.allocated++ & ( cMaxJobsPerThread - 1 )];
+
+    // The ring wrapped around onto a job that hasn't finished yet
+    if ( job->unfinished.load( std::memory_order_acquire ) != 0 )
+      ENGINE_EXCEPT( "Job pool overflow" );
+
+    job->function = function;
+    job->parent = nullptr;
+    job->unfinished.store( 1, std::memory_order_relaxed );
+    job->continuationCount.store( 0, std::memory_order_relaxed );
+    if ( data && size )
+      memcpy( job->payload, data, size );
+
+    return job;
+  }
+
+  Job* JobSystem::createChild( Job* parent, JobFunction function, const void* data, size_t size )
+  {
+    if ( parent )
+      parent->unfinished.fetch_add( 1, std::memory_order_relaxed );
+
+    Job* job = createJob( function, data, size );
+    job->parent = parent;
+
+    return job;
+  }
+
+  void JobSystem::addContinuation( Job* ancestor, Job* continuation )
+  {
+    long index = ancestor->continuationCount.fetch_add( 1, std::memory_order_relaxed );
+    if ( index >= cMaxJobContinuations )
+      ENGINE_EXCEPT( "Too many continuations for job" );
+
+    ancestor->continuations[index] = continuation;
+  }
+
+  void JobSystem::run( Job* job )
+  {
+    getThreadData().queue.push( job );
+
+    // Wake up one sleeper, if there are any
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if ( mSleeping.load( std::memory_order_relaxed ) > 0 )
+      ReleaseSemaphore( mWakeSemaphore, 1, NULL );
+  }
+
+  bool JobSystem::isFinished( const Job* job ) const
+  {
+    return ( job->unfinished.load( std::memory_order_acquire ) == 0 );
+  }
+
+  Job* JobSystem::getJob()
+  {
+    auto& thread = getThreadData();
+
+    Job* job = thread.queue.pop();
+    if ( job )
+      return job;
+
+    // Our own queue is empty, try stealing from the others
+    size_t count = mThreads.size();
+    for ( size_t i = 1; i < count; i++ )
+    {
+      size_t victim = ( tJobThreadIndex + i ) % count;
+      job = mThreads[victim]->queue.steal();
+      if ( job )
+      {
+        thread.stolen.fetch_add( 1, std::memory_order_relaxed );
+        return job;
+      }
+    }
+
+    return nullptr;
+  }
+
+  void JobSystem::execute( Job* job )
+  {
+    if ( job->function )
+    {
+      GLACIER_PROFILE( "Job" );
+      job->function( job, job->payload );
+    }
+
+    getThreadData().executed.fetch_add( 1, std::memory_order_relaxed );
+
+    finish( job );
+  }
+
+  void JobSystem::finish( Job* job )
+  {
+    // Once the count hits zero the slot may be reused at any moment,
+    // so take everything we need from it before that
+    Job* parent = job->parent;
+    Job* continuations[cMaxJobContinuations];
+    long count = std::min( job->continuationCount.load( std::memory_order_acquire ),
+      (long)cMaxJobContinuations );
+    for ( long i = 0; i < count; i++ )
+      continuations[i] = job->continuations[i];
+
+    if ( job->unfinished.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+      return;
+
+    for ( long i = 0; i < count; i++ )
+      run( continuations[i] );
+
+    if ( parent )
+      finish( parent );
+  }
+
+  void JobSystem::sleep()
+  {
+    // Spin a while before going to sleep, new work usually arrives in bursts
+    for ( uint32_t i = 0; i < cJobSpinCount; i++ )
+    {
+      for ( auto thread : mThreads )
+        if ( thread->queue.size() > 0 )
+          return;
+      YieldProcessor();
+    }
+
+    mSleeping.fetch_add( 1, std::memory_order_seq_cst );
+
+    // Re-check after announcing ourselves, so that we don't miss a wakeup
+    bool empty = true;
+    for ( auto thread : mThreads )
+      if ( thread->queue.size() > 0 )
+        empty = false;
+
+    if ( empty )
+    {
+      HANDLE events[2] = { mWakeSemaphore, mShutdownEvent };
+      WaitForMultipleObjects( 2, events, FALSE, INFINITE );
+    }
+
+    mSleeping.fetch_sub( 1, std::memory_order_acq_rel );
+  }
+
+  void JobSystem::wait( const Job* job )
+  {
+    while ( !isFinished( job ) )
+    {
+      Job* next = getJob();
+      if ( next )
+        execute( next );
+      else
+        YieldProcessor();
+    }
+  }
+
+  struct RangeJobData {
+    JobRangeFunction function;
+    void* context;
+    size_t begin;
+    size_t end;
+  };
+
+  void JobSystem::rangeJob( Job* job, const void* data )
+  {
+    auto range = (const RangeJobData*)data;
+    range->function( range->begin, range->end, range->context );
+  }
+
+  Job* JobSystem::parallelFor( Job* parent, size_t count, size_t batchSize,
+  JobRangeFunction function, void* context )
+  {
+    if ( batchSize == 0 )
+      batchSize = 1;
+
+    // Clamp the batch count so that a single call can't exhaust the job ring
+    size_t batches = ( count + batchSize - 1 ) / batchSize;
+    if ( batches > cMaxParallelForBatches )
+      batchSize = ( count + cMaxParallelForBatches - 1 ) / cMaxParallelForBatches;
+
+    Job* group = createChild( parent, nullptr );
+
+    for ( size_t begin = 0; begin < count; begin += batchSize )
+    {
+      RangeJobData range = { function, context, begin, std::min( begin + batchSize, count ) };
+      run( createChild( group, rangeJob, &range, sizeof( range ) ) );
+    }
+
+    run( group );
+
+    return group;
+  }
+
+  void JobSystem::beginStep()
+  {
+    assert( !mStepJob );
+    mStepJob = createJob( nullptr );
+  }
+
+  void JobSystem::endStep()
+  {
+    assert( mStepJob );
+    run( mStepJob );
+    wait( mStepJob );
+    mStepJob = nullptr;
+  }
+
+  void JobSystem::callbackStats( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getJobs() )
+      return;
+
+    auto jobs = gEngine->getJobs();
+    for ( size_t i = 0; i < jobs->mThreads.size(); i++ )
+    {
+      auto thread = jobs->mThreads[i];
+      console->printf( Console::srcEngine,
+        L"Thread %d: executed %I64u, stolen %I64u, queued %d",
+        (int)i, thread->executed.load(), thread->stolen.load(), (int)thread->queue.size() );
+    }
+  }
+
+  JobSystem::~JobSystem()
+  {
+    SetEvent( mShutdownEvent );
+
+    for ( auto worker : mWorkers )
+      delete worker;
+    mWorkers.clear();
+
+    for ( auto thread : mThreads )
+      delete thread;
+    mThreads.clear();
+
+    tJobThreadIndex = cInvalidJobThread;
+
+    SAFE_CLOSE_HANDLE( mWakeSemaphore );
+    SAFE_CLOSE_HANDLE( mShutdownEvent );
+  }
+
+}
\ No newline at end of file
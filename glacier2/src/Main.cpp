@@ -45,6 +45,8 @@ LPWSTR lpCmdLine, int nCmdShow )
       options.noAudio = true;
     } else if ( _wcsicmp( arguments[i], L"-nophysics" ) == 0 ) {
       options.noPhysics = true;
+    } else if ( _wcsicmp( arguments[i], L"-headless" ) == 0 ) {
+      options.headless = true;
     } else if ( _wcsicmp( arguments[i], L"-exec" ) == 0 ) {
       i++;
       if ( i < argCount )
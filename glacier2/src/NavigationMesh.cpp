@@ -3,6 +3,7 @@
 #include "GlacierMath.h"
 #include "Exception.h"
 #include "ServiceLocator.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -188,6 +189,8 @@ namespace Glacier {
 
   void NavigationMesh::buildFrom( NavigationInputGeometry* geometry )
   {
+    GLACIER_PROFILE_FUNCTION();
+
     mContext->resetTimers();
     mContext->startTimer( RC_TIMER_TOTAL );
 
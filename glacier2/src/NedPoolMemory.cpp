@@ -11,12 +11,14 @@ namespace Glacier {
   const wstring cNedPoolProviderName( L"Nedmalloc Pooled" );
 
   NedPoolMemory::NedPoolMemory(): mGenericPool( nullptr ),
-  mAudioPool( nullptr ), mPhysicsPool( nullptr ), mNavigationPool( nullptr )
+  mAudioPool( nullptr ), mPhysicsPool( nullptr ), mNavigationPool( nullptr ),
+  mEntityPool( nullptr )
   {
     mGenericPool = glacier_nedalloc::nedcreatepool( 10240, 2 );
     mAudioPool = glacier_nedalloc::nedcreatepool( 10240, 2 );
     mPhysicsPool = glacier_nedalloc::nedcreatepool( 10240, 2 );
     mNavigationPool = glacier_nedalloc::nedcreatepool( 10240, 2 );
+    mEntityPool = glacier_nedalloc::nedcreatepool( 10240, 2 );
   }
 
   NedPoolMemory::~NedPoolMemory()
@@ -29,6 +31,8 @@ namespace Glacier {
       glacier_nedalloc::neddestroypool( mPhysicsPool );
     if ( mNavigationPool )
       glacier_nedalloc::neddestroypool( mNavigationPool );
+    if ( mEntityPool )
+      glacier_nedalloc::neddestroypool( mEntityPool );
   }
 
   void* NedPoolMemory::alloc( const Sector sector, size_t size, size_t alignment )
@@ -4,6 +4,9 @@
 #include "Exception.h"
 #include "ServiceLocator.h"
 #include "PhysicsScene.h"
+#include "Profiler.h"
+#include "ThreadPlacement.h"
+#include "CookedMeshCache.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -14,6 +17,8 @@ namespace Glacier {
 
   PxDefaultCpuDispatcher* gDispatcher = nullptr;
 
+  const wchar_t* cCookedMeshDirectory = L"meshcache";
+
   void* PhysXPhysics::Allocator::allocate( size_t size, const char* typeName,
   const char* filename, int line )
   {
@@ -31,6 +36,13 @@ namespace Glacier {
     L"Number of PhysX dispatch threads.", 2 );
   ENGINE_DECLARE_CONVAR( px_cuda,
     L"Enable CUDA utilisation in physics.", true );
+  ENGINE_DECLARE_CONVAR( px_pipelined,
+    L"Overlap physics simulation with gameplay logic, syncing before entity think.", true );
+  ENGINE_DECLARE_CONVAR( px_substeps,
+    L"Fixed physics substeps per logic step, for stable stacking at low logic rates.", 1 );
+  ENGINE_DECLARE_CONCMD( px_stats,
+    L"Print physics scene statistics & last step substep timings.",
+    PhysXPhysics::callbackStats );
   ENGINE_DECLARE_CONVAR( px_gravity,
     L"World gravity in metres per second.", 9.81f );
   ENGINE_DECLARE_CONVAR( px_restitution,
@@ -40,11 +52,51 @@ namespace Glacier {
   ENGINE_DECLARE_CONVAR( px_dynamicfriction,
     L"Default dynamic friction coefficient for world materials.", 0.9f );
 
+  // DispatcherPlacementTask class ============================================
+
+  //! Places one PhysX dispatcher thread with its full affinity mask, which
+  //! the SDK's own affinity parameter would truncate to 32 bits. Each task
+  //! holds its thread until all of them have run, so that every dispatcher
+  //! thread picks up exactly one.
+  class DispatcherPlacementTask: public PxBaseTask {
+  protected:
+    ThreadPlacement* mPlacement;
+    std::atomic<long>* mClaimed; //!< Thread indices handed out
+    std::atomic<long>* mPlaced; //!< Threads placed
+    std::atomic<long>* mReleased; //!< Tasks the dispatcher is done with
+    long mCount;
+    HANDLE mPlacedEvent; //!< Set once every thread has been placed
+  public:
+    DispatcherPlacementTask( ThreadPlacement* placement,
+      std::atomic<long>* claimed, std::atomic<long>* placed,
+      std::atomic<long>* released, long count, HANDLE placedEvent ):
+    mPlacement( placement ), mClaimed( claimed ), mPlaced( placed ),
+    mReleased( released ), mCount( count ), mPlacedEvent( placedEvent ) {}
+    virtual void run()
+    {
+      auto index = mClaimed->fetch_add( 1 );
+      wchar_t name[64];
+      swprintf_s( name, 64, L"PhysX Dispatcher %d", index );
+      mPlacement->place( GetCurrentThread(), GetCurrentThreadId(),
+        ThreadPlacement::Role_Physics, (uint32_t)index, name );
+      if ( mPlaced->fetch_add( 1 ) + 1 == mCount )
+        SetEvent( mPlacedEvent );
+      else
+        WaitForSingleObject( mPlacedEvent, INFINITE );
+    }
+    virtual const char* getName() const { return "DispatcherPlacement"; }
+    virtual void addReference() {}
+    virtual void removeReference() {}
+    virtual PxI32 getReference() const { return 1; }
+    //! Last call the dispatcher makes on the task.
+    virtual void release() { mReleased->fetch_add( 1 ); }
+  };
+
   // Physics class ============================================================
 
   PhysXPhysics::PhysXPhysics( Engine* engine ): EngineComponent( engine ),
     mFoundation( nullptr ), mPhysics( nullptr ), mCooking( nullptr ),
-    mCPUDispatcher( nullptr )
+    mMeshCache( nullptr ), mSerialization( nullptr ), mCPUDispatcher( nullptr ), mSimulating( false )
   {
     initialize();
   }
@@ -122,8 +174,34 @@ namespace Glacier {
       ENGINE_EXCEPT( "PhysX Extensions initialization failed" );
     PxRegisterHeightFields( *mPhysics );
 
-    // Create CPU dispatcher
-    mCPUDispatcher = PxDefaultCpuDispatcherCreate( g_CVar_px_threads.getInt() );
+    // Create serialization registry for binary scene collections
+    mSerialization = PxSerialization::createSerializationRegistry( *mPhysics );
+    if ( !mSerialization )
+      ENGINE_EXCEPT( "PhysX Serialization registry creation failed" );
+
+    // Create CPU dispatcher, keeping its threads off the engine's cores
+    auto threads = (PxU32)std::max( g_CVar_px_threads.getInt(), 0 );
+    auto placement = mEngine->getPlacement();
+    mCPUDispatcher = PxDefaultCpuDispatcherCreate( threads, nullptr );
+    if ( !mCPUDispatcher )
+      ENGINE_EXCEPT( "PhysX CPU dispatcher creation failed" );
+    if ( threads > 0 )
+    {
+      // Dispatcher threads are only reachable from tasks they run
+      HANDLE placedEvent = CreateEventW( NULL, TRUE, FALSE, NULL );
+      if ( !placedEvent )
+        ENGINE_EXCEPT_WINAPI( "Could not create dispatcher placement event" );
+      std::atomic<long> claimed( 0 ), placed( 0 ), released( 0 );
+      vector<DispatcherPlacementTask> tasks( threads, DispatcherPlacementTask(
+        placement, &claimed, &placed, &released, (long)threads, placedEvent ) );
+      for ( auto& task : tasks )
+        mCPUDispatcher->submitTask( task );
+      WaitForSingleObject( placedEvent, INFINITE );
+      // The tasks and their event must outlive the dispatcher's use of them
+      while ( released.load() < (long)threads )
+        YieldProcessor();
+      CloseHandle( placedEvent );
+    }
 
     // Initialize cooking parameters
     PxCookingParams cookingParams( scale );
@@ -138,6 +216,13 @@ namespace Glacier {
     if ( !mCooking )
       ENGINE_EXCEPT( "PhysX Cooking initialization failed" );
 
+    // Cook in the background, and only what hasn't been cooked before
+    mMeshCache = new CookedMeshCache( mPhysics, mCooking, cookingParams,
+      cCookedMeshDirectory );
+    auto cooker = mMeshCache->getCooker();
+    placement->place( cooker->getThread(), cooker->getThreadID(),
+      ThreadPlacement::Role_IO, 1, L"Mesh cooker" );
+
     mEngine->operationContinuePhysics();
   }
 
@@ -172,28 +257,108 @@ namespace Glacier {
 
   void PhysXPhysics::destroyScene( PhysicsScene* scene )
   {
+    simulationSync();
     mScenes.remove( scene );
     SAFE_DELETE( scene );
   }
 
   void PhysXPhysics::componentPreUpdate( GameTime time )
   {
-    //
+    GLACIER_PROFILE_FUNCTION();
   }
 
-  void PhysXPhysics::componentTick( GameTime tick, GameTime time )
+  void PhysXPhysics::simulationBegin( GameTime tick, GameTime time )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    assert( !mSimulating );
+
+    auto substeps = (uint32_t)std::max( g_CVar_px_substeps.getInt(), 1 );
+    for ( auto scene : mScenes )
+      scene->simulationStep( tick, time, substeps );
+
+    mSimulating = true;
+  }
+
+  bool PhysXPhysics::simulationPoll()
   {
+    GLACIER_PROFILE_FUNCTION();
+
+    if ( !mSimulating )
+      return true;
+
+    bool finished = true;
+    for ( auto scene : mScenes )
+      finished = ( scene->simulationPoll() && finished );
+
+    return finished;
+  }
+
+  void PhysXPhysics::simulationSync()
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    if ( !mSimulating )
+      return;
+
+    // Substeps chain per scene, so instead of blocking on one scene while
+    // another sits finished, wake on whichever is ready first and start its
+    // next substep right away
+    vector<PhysicsScene*> running;
+    vector<HANDLE> events;
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency( &frequency );
+    while ( true )
+    {
+      running.clear();
+      events.clear();
+      for ( auto scene : mScenes )
+      {
+        if ( scene->simulationPoll() )
+          continue;
+        running.push_back( scene );
+        events.push_back( scene->getSubstepEvent() );
+      }
+      if ( running.empty() )
+        break;
+
+      assert( events.size() <= MAXIMUM_WAIT_OBJECTS );
+
+      LARGE_INTEGER before, after;
+      QueryPerformanceCounter( &before );
+      WaitForMultipleObjects( (DWORD)events.size(), events.data(), FALSE, INFINITE );
+      QueryPerformanceCounter( &after );
+
+      // Every scene still running held the sync up for the wait
+      auto waited = (float)( (double)( after.QuadPart - before.QuadPart ) * 1000.0
+        / (double)frequency.QuadPart );
+      for ( auto scene : running )
+        scene->mCurrent.blocked += waited;
+    }
+
     for ( auto scene : mScenes )
     {
-      scene->simulationStep( tick, time );
       scene->simulationFetchResults();
       scene->post();
     }
+
+    mSimulating = false;
+  }
+
+  void PhysXPhysics::componentTick( GameTime tick, GameTime time )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    simulationBegin( tick, time );
+
+    // When pipelined, the engine syncs us later in the logic step
+    if ( !g_CVar_px_pipelined.getBool() )
+      simulationSync();
   }
 
   void PhysXPhysics::componentPostUpdate( GameTime delta, GameTime time )
   {
-    //
+    GLACIER_PROFILE_FUNCTION();
   }
 
   void PhysXPhysics::shutdown()
@@ -205,8 +370,11 @@ namespace Glacier {
 
     assert( mScenes.empty() );
 
+    SAFE_DELETE( mMeshCache );
     SAFE_RELEASE_PHYSX( mCPUDispatcher );
 
+    SAFE_RELEASE_PHYSX( mSerialization );
+
     if ( mPhysics )
     {
       PxCloseExtensions();
@@ -228,4 +396,28 @@ namespace Glacier {
     shutdown();
   }
 
+  void PhysXPhysics::callbackStats( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getPhysics() )
+      return;
+
+    int index = 0;
+    for ( auto scene : gEngine->getPhysics()->mScenes )
+    {
+      auto& statistics = scene->getStatistics();
+      auto& timings = scene->getTimings();
+      console->printf( Console::srcPhysics,
+        L"Scene %d: %u static, %u dynamic (%u active), %u kinematic bodies",
+        index++, statistics.nbStaticBodies, statistics.nbDynamicBodies,
+        statistics.nbActiveDynamicBodies, statistics.nbActiveKinematicBodies );
+      console->printf( Console::srcPhysics,
+        L"  %u substeps, %.3fms blocked on results",
+        timings.substeps, timings.blocked );
+      for ( uint32_t i = 0; i < timings.substeps; i++ )
+        console->printf( Console::srcPhysics,
+          L"  substep %u: %.3fms", i, timings.substep[i] );
+    }
+  }
+
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "PhysicsScene.h"
 #include "GlacierMath.h"
 #include "PhysicsDebugVisualizer.h"
+#include "SceneQueries.h"
+#include "World.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -14,14 +16,44 @@ namespace Glacier {
 
   using namespace physx;
 
+  const uint32_t cCollectionMagic = 'LCXP';
+  const uint32_t cCollectionVersion = 2;
+  const PxSerialObjectId cDefaultMaterialId = 1;
+
+  ENGINE_DECLARE_CONCMD( px_export,
+    L"Write the world's static physics actors, or all rigid ones, to a binary collection. Format: px_export <filename> [all]",
+    PhysicsScene::callbackExport );
+
+  //! Header of a collection file, padded so the data that follows stays
+  //! aligned for in place deserialization when mapped.
+  struct CollectionFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sdk; //!< PX_PHYSICS_VERSION the data was serialized with
+    uint32_t size; //!< Collection data size in bytes
+    uint64_t source; //!< Hash of what the actors were built from
+    uint8_t padding[PX_SERIAL_FILE_ALIGN - 24];
+  };
+
   PhysicsScene::PhysicsScene( PhysXPhysics* physics,
   PxCpuDispatcher* cpuDispatcher, PxGpuDispatcher* gpuDispatcher,
   const float gravity, const float restitution, const float staticFriction,
   const float dynamicFriction ):
   mPhysics( physics ), mScene( nullptr ), mCPUDispatcher( cpuDispatcher ),
   mGPUDispatcher( gpuDispatcher ), mVisualizer( nullptr ),
-  mControllerMgr( nullptr )
+  mControllerMgr( nullptr ), mQueries( nullptr ), mActorBatchDepth( 0 ),
+  mSubsteps( 0 ), mSubstep( 0 ), mSubstepDelta( 0.0f ), mRunning( false ),
+  mSubstepEvent( NULL )
   {
+    QueryPerformanceFrequency( &mFrequency );
+
+    mSubstepEvent = CreateEventW( NULL, FALSE, FALSE, NULL );
+    if ( !mSubstepEvent )
+      ENGINE_EXCEPT_WINAPI( "Could not create substep event" );
+    mSubstepTask.setEvent( mSubstepEvent );
+    memset( &mCurrent, 0, sizeof( mCurrent ) );
+    memset( &mTimings, 0, sizeof( mTimings ) );
+
     PxSceneDesc sceneDescriptor( mPhysics->getPhysics()->getTolerancesScale() );
 
     PxVec3 g( 0.0f, -gravity, 0.0f );
@@ -31,6 +63,8 @@ namespace Glacier {
     sceneDescriptor.cpuDispatcher = mCPUDispatcher;
     sceneDescriptor.gpuDispatcher = mGPUDispatcher;
     sceneDescriptor.filterShader = PxDefaultSimulationFilterShader;
+    // Report moved bodies, so that poses at rest are never read back
+    sceneDescriptor.flags |= PxSceneFlag::eENABLE_ACTIVETRANSFORMS;
 
     mScene = mPhysics->getPhysics()->createScene( sceneDescriptor );
     if ( !mScene )
@@ -42,17 +76,89 @@ namespace Glacier {
     mControllerMgr = PxCreateControllerManager( *mScene );
     if ( !mControllerMgr )
       ENGINE_EXCEPT( "Couldn't create character controller manager" );
+
+    mQueries = new SceneQueries( mScene );
+  }
+
+  void PhysicsScene::simulationStep( const GameTime delta, const GameTime time,
+  const uint32_t substeps )
+  {
+    assert( !mRunning );
+
+    mSubsteps = std::min( std::max( substeps, 1u ), cMaxPhysicsSubsteps );
+    mSubstep = 0;
+    mSubstepDelta = (PxReal)( delta / (GameTime)mSubsteps );
+
+    memset( &mCurrent, 0, sizeof( mCurrent ) );
+    mCurrent.substeps = mSubsteps;
+    mActiveTransforms.clear();
+
+    beginSubstep();
+  }
+
+  void PhysicsScene::beginSubstep()
+  {
+    QueryPerformanceCounter( &mSubstepStart );
+
+    // The completion task runs on the dispatcher once results are ready,
+    // the previous substep's run may still be pending on it. Drop the
+    // signal it left if nobody waited for it
+    mSubstepTask.wait();
+    ResetEvent( mSubstepEvent );
+    mSubstepTask.arm();
+    mSubstepTask.setContinuation( *mScene->getTaskManager(), nullptr );
+    mScene->simulate( mSubstepDelta, &mSubstepTask );
+    mSubstepTask.removeReference();
+    mSubstep++;
+    mRunning = true;
+  }
+
+  bool PhysicsScene::finishSubstep( const bool block )
+  {
+    LARGE_INTEGER before, now;
+    QueryPerformanceCounter( &before );
+
+    if ( !mScene->fetchResults( block ) )
+      return false;
+
+    QueryPerformanceCounter( &now );
+    if ( block )
+      mCurrent.blocked += (float)( (double)( now.QuadPart - before.QuadPart ) * 1000.0
+        / (double)mFrequency.QuadPart );
+    mCurrent.substep[mSubstep - 1] = (float)( (double)( now.QuadPart - mSubstepStart.QuadPart )
+      * 1000.0 / (double)mFrequency.QuadPart );
+    mRunning = false;
+
+    // Active transforms only last until the next simulate, and a body that
+    // falls asleep during an earlier substep isn't listed by the later ones
+    PxU32 count = 0;
+    auto transforms = mScene->getActiveTransforms( count );
+    mActiveTransforms.insert( mActiveTransforms.end(), transforms, transforms + count );
+
+    // Each substep simulates on the results of the previous one
+    if ( mSubstep < mSubsteps )
+      beginSubstep();
+
+    return true;
   }
 
-  void PhysicsScene::simulationStep( const GameTime delta, const GameTime time )
+  bool PhysicsScene::simulationPoll()
   {
-    mScene->simulate( (PxReal)delta );
+    while ( mRunning && finishSubstep( false ) );
+
+    return !mRunning;
   }
 
   void PhysicsScene::simulationFetchResults()
   {
-    mScene->fetchResults( true );
+    while ( mRunning )
+      finishSubstep( true );
+
+    mTimings = mCurrent;
     mScene->getSimulationStatistics( mStatistics );
+
+    // The scene is ours until the next simulate, answer queued queries now
+    mQueries->execute();
   }
 
   void PhysicsScene::post()
@@ -98,6 +204,166 @@ namespace Glacier {
   }
 #endif
 
+  void PhysicsScene::addActor( PxActor& actor )
+  {
+    if ( mActorBatchDepth > 0 )
+      mPendingActors.push_back( &actor );
+    else
+      mScene->addActor( actor );
+  }
+
+  void PhysicsScene::beginActorBatch()
+  {
+    mActorBatchDepth++;
+  }
+
+  void PhysicsScene::endActorBatch()
+  {
+    assert( mActorBatchDepth > 0 );
+
+    if ( --mActorBatchDepth > 0 || mPendingActors.empty() )
+      return;
+
+    mScene->addActors( mPendingActors.data(), (PxU32)mPendingActors.size() );
+    mPendingActors.clear();
+  }
+
+  PxCollection* PhysicsScene::createSharedCollection()
+  {
+    auto shared = PxCreateCollection();
+    shared->add( *mDefaultMaterial, cDefaultMaterialId );
+
+    return shared;
+  }
+
+  bool PhysicsScene::exportCollection( const wstring& filename,
+  PxActorTypeFlags types, uint64_t source )
+  {
+    auto registry = mPhysics->getSerialization();
+
+    vector<PxActor*> actors( mScene->getNbActors( types ) );
+    if ( !actors.empty() )
+      mScene->getActors( types, actors.data(), (PxU32)actors.size() );
+
+    auto shared = createSharedCollection();
+    auto collection = PxCreateCollection();
+    for ( auto actor : actors )
+      collection->add( *actor );
+
+    // Pull in shapes, meshes & materials, except the shared default material
+    PxSerialization::complete( *collection, *registry, shared );
+
+    PxDefaultMemoryOutputStream stream;
+    bool serialized = ( PxSerialization::isSerializable( *collection, *registry, shared )
+      && PxSerialization::serializeCollectionToBinary( stream, *collection, *registry, shared ) );
+
+    collection->release();
+    shared->release();
+
+    if ( !serialized )
+      return false;
+
+    // Write to a temporary first, so that a torn write never looks valid
+    auto temporary = filename + L".tmp";
+
+    HANDLE file = CreateFileW( temporary.c_str(), GENERIC_WRITE,
+      0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
+    if ( file == INVALID_HANDLE_VALUE )
+      return false;
+
+    CollectionFileHeader header;
+    memset( &header, 0, sizeof( header ) );
+    header.magic = cCollectionMagic;
+    header.version = cCollectionVersion;
+    header.sdk = PX_PHYSICS_VERSION;
+    header.size = stream.getSize();
+    header.source = source;
+
+    DWORD written;
+    BOOL ret = WriteFile( file, &header, sizeof( header ), &written, nullptr );
+    if ( ret )
+      ret = WriteFile( file, stream.getData(), stream.getSize(), &written, nullptr );
+    CloseHandle( file );
+
+    if ( !ret || !MoveFileExW( temporary.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING ) )
+    {
+      DeleteFileW( temporary.c_str() );
+      return false;
+    }
+
+    return true;
+  }
+
+  ImportedCollection* PhysicsScene::importCollection( const wstring& filename,
+  uint64_t source )
+  {
+    auto imported = new ImportedCollection();
+    imported->collection = nullptr;
+    imported->mapping = NULL;
+    imported->view = nullptr;
+
+    imported->file = CreateFileW( filename.c_str(), GENERIC_READ,
+      FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+    if ( imported->file == INVALID_HANDLE_VALUE )
+    {
+      delete imported;
+      return nullptr;
+    }
+
+    // Views are page aligned, and the header keeps the data aligned after it
+    LARGE_INTEGER size;
+    if ( GetFileSizeEx( imported->file, &size ) && size.QuadPart > sizeof( CollectionFileHeader ) )
+    {
+      imported->mapping = CreateFileMappingW( imported->file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr );
+      if ( imported->mapping )
+        imported->view = MapViewOfFile( imported->mapping, FILE_MAP_COPY, 0, 0, 0 );
+    }
+
+    if ( imported->view )
+    {
+      auto header = (const CollectionFileHeader*)imported->view;
+      if ( header->magic == cCollectionMagic && header->version == cCollectionVersion
+        && header->sdk == PX_PHYSICS_VERSION && header->source == source
+        && sizeof( CollectionFileHeader ) + header->size <= (uint64_t)size.QuadPart )
+      {
+        auto shared = createSharedCollection();
+        imported->collection = PxSerialization::createCollectionFromBinary(
+          (uint8_t*)imported->view + sizeof( CollectionFileHeader ),
+          *mPhysics->getSerialization(), shared );
+        shared->release();
+      }
+    }
+
+    if ( !imported->collection )
+    {
+      releaseCollection( imported );
+      return nullptr;
+    }
+
+    mScene->addCollection( *imported->collection );
+    mImports.push_back( imported );
+
+    return imported;
+  }
+
+  void PhysicsScene::releaseCollection( ImportedCollection* imported )
+  {
+    if ( imported->collection )
+    {
+      PxCollectionExt::releaseObjects( *imported->collection );
+      imported->collection->release();
+    }
+    if ( imported->view )
+      UnmapViewOfFile( imported->view );
+    if ( imported->mapping )
+      CloseHandle( imported->mapping );
+    if ( imported->file != INVALID_HANDLE_VALUE )
+      CloseHandle( imported->file );
+
+    mImports.remove( imported );
+    delete imported;
+  }
+
   float PhysicsScene::setGravity( const float gravity )
   {
     PxVec3 g( 0.0f, -gravity, 0.0f );
@@ -127,15 +393,47 @@ namespace Glacier {
 
   PhysicsScene::~PhysicsScene()
   {
+    // The last substep's completion task touches the event
+    mSubstepTask.wait();
 #ifndef GLACIER_NO_PHYSICS_DEBUG
     SAFE_DELETE( mVisualizer );
 #endif
+    while ( !mImports.empty() )
+      releaseCollection( mImports.front() );
+    SAFE_DELETE( mQueries );
     if ( mControllerMgr )
     {
       mControllerMgr->purgeControllers();
       mControllerMgr->release();
     }
     SAFE_RELEASE_PHYSX( mScene );
+    if ( mSubstepEvent )
+      CloseHandle( mSubstepEvent );
+  }
+
+  void PhysicsScene::callbackExport( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( arguments.size() < 2 || arguments.size() > 3 )
+    {
+      console->errorPrintf( Console::srcPhysics, L"Format: px_export <filename> [all]" );
+      return;
+    }
+
+    if ( !gEngine || !gEngine->getWorld() || !gEngine->getWorld()->getPhysics() )
+      return;
+
+    // Static level geometry by default, everything rigid if asked
+    PxActorTypeFlags types = PxActorTypeFlag::eRIGID_STATIC;
+    if ( arguments.size() > 2 && arguments[2] == L"all" )
+      types |= PxActorTypeFlag::eRIGID_DYNAMIC;
+
+    if ( gEngine->getWorld()->getPhysics()->exportCollection( arguments[1], types ) )
+      console->printf( Console::srcPhysics,
+        L"Wrote physics collection to %s", arguments[1].c_str() );
+    else
+      console->errorPrintf( Console::srcPhysics,
+        L"Failed to write physics collection to %s", arguments[1].c_str() );
   }
 
 }
\ No newline at end of file
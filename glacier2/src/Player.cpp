@@ -33,6 +33,9 @@ namespace Glacier {
   {
     Character::spawn( position, orientation );
 
+    if ( !mNode )
+      return;
+
     mMesh = Procedural::CapsuleGenerator().setHeight( mHeight ).setRadius( mRadius ).realizeMesh( "playerStandCapsule" );
 
     mItem = Locator::getGraphics().getScene()->createItem( mMesh );
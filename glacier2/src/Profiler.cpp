@@ -0,0 +1,192 @@
+#include "StdAfx.h"
+#include "Profiler.h"
+#include "Engine.h"
+#include "Console.h"
+#include "Exception.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  const wchar_t* cProfilerDefaultDump = L"profile.json";
+
+  //! The calling thread's ring, or null until it first records something.
+  thread_local ProfilerRing* tProfilerRing = nullptr;
+
+  ENGINE_DECLARE_CONVAR_WITH_CB( prof_enabled,
+    L"Record profiling scopes for prof_dump.", false, Profiler::callbackEnabled );
+  ENGINE_DECLARE_CONCMD( prof_dump,
+    L"Write recorded profiling scopes to a Chrome trace JSON file. Format: prof_dump [filename]",
+    Profiler::callbackDump );
+
+  vector<ProfilerRing*> Profiler::fRings;
+  std::map<DWORD, string> Profiler::fThreadNames;
+  Platform::RWLock Profiler::fRingsLock;
+  LARGE_INTEGER Profiler::fFrequency = { 0 };
+  volatile bool Profiler::fEnabled = false;
+
+  // ProfilerRing class =======================================================
+
+  ProfilerRing::ProfilerRing( DWORD threadID ): mThreadID( threadID ),
+  mHead( 0 )
+  {
+    //
+  }
+
+  // Profiler class ===========================================================
+
+  ProfilerRing* Profiler::createRing()
+  {
+    auto ring = new ProfilerRing( GetCurrentThreadId() );
+
+    ScopedRWLock lock( &fRingsLock );
+    if ( !fFrequency.QuadPart )
+      QueryPerformanceFrequency( &fFrequency );
+    fRings.push_back( ring );
+
+    return ring;
+  }
+
+  ProfilerRing* Profiler::getRing()
+  {
+    if ( !tProfilerRing )
+      tProfilerRing = createRing();
+
+    return tProfilerRing;
+  }
+
+  void Profiler::setThreadName( const string& name )
+  {
+    ScopedRWLock lock( &fRingsLock );
+    fThreadNames[GetCurrentThreadId()] = name;
+  }
+
+  inline void appendEscaped( string& out, const char* str )
+  {
+    for ( ; *str; str++ )
+    {
+      if ( *str == '"' || *str == '\\' )
+        out.push_back( '\\' );
+      out.push_back( *str );
+    }
+  }
+
+  bool Profiler::dump( const wstring& filename )
+  {
+    ScopedRWLock lock( &fRingsLock, false );
+
+    if ( !fFrequency.QuadPart )
+      return false;
+
+    const double toMicroseconds = 1000000.0 / (double)fFrequency.QuadPart;
+
+    // Rebase timestamps to the earliest recorded event
+    int64_t base = INT64_MAX;
+    for ( auto ring : fRings )
+    {
+      uint64_t head = ring->mHead.load( std::memory_order_acquire );
+      uint64_t tail = ( head > cProfilerRingSize ? head - cProfilerRingSize : 0 );
+      for ( uint64_t i = tail; i < head; i++ )
+        base = std::min( base, ring->mEvents[i & ( cProfilerRingSize - 1 )].start );
+    }
+
+    string out;
+    out.reserve( 1024 * 1024 );
+    out.append( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+    char buffer[128];
+    bool first = true;
+    for ( auto ring : fRings )
+    {
+      auto name = fThreadNames.find( ring->mThreadID );
+      if ( name != fThreadNames.end() )
+      {
+        sprintf_s( buffer, 128,
+          "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+          first ? "" : ",", ring->mThreadID );
+        out.append( buffer );
+        appendEscaped( out, name->second.c_str() );
+        out.append( "\"}}" );
+        first = false;
+      }
+
+      // Events may be overwritten while we read if the thread is still
+      // recording; such events are simply garbage in the trace, not a crash
+      uint64_t head = ring->mHead.load( std::memory_order_acquire );
+      uint64_t tail = ( head > cProfilerRingSize ? head - cProfilerRingSize : 0 );
+      for ( uint64_t i = tail; i < head; i++ )
+      {
+        auto& evt = ring->mEvents[i & ( cProfilerRingSize - 1 )];
+        out.append( first ? "{" : ",{" );
+        out.append( "\"ph\":\"X\",\"pid\":1,\"name\":\"" );
+        first = false;
+        appendEscaped( out, evt.name );
+        sprintf_s( buffer, 128, "\",\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+          ring->mThreadID,
+          (double)( evt.start - base ) * toMicroseconds,
+          (double)( evt.end - evt.start ) * toMicroseconds );
+        out.append( buffer );
+      }
+    }
+
+    out.append( "]}" );
+
+    HANDLE file = CreateFileW( filename.c_str(), GENERIC_WRITE,
+      FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
+    if ( file == INVALID_HANDLE_VALUE )
+      return false;
+
+    DWORD written;
+    BOOL ret = WriteFile( file, out.c_str(), (DWORD)out.size(), &written, nullptr );
+    CloseHandle( file );
+
+    return ( ret != FALSE );
+  }
+
+  void Profiler::releaseThread()
+  {
+    ScopedRWLock lock( &fRingsLock );
+    fThreadNames.erase( GetCurrentThreadId() );
+    if ( !tProfilerRing )
+      return;
+
+    fRings.erase( std::remove( fRings.begin(), fRings.end(), tProfilerRing ),
+      fRings.end() );
+    delete tProfilerRing;
+    tProfilerRing = nullptr;
+  }
+
+  void Profiler::shutdown()
+  {
+    fEnabled = false;
+
+    ScopedRWLock lock( &fRingsLock );
+    for ( auto ring : fRings )
+      delete ring;
+    fRings.clear();
+    fThreadNames.clear();
+    tProfilerRing = nullptr;
+  }
+
+  bool Profiler::callbackEnabled( ConVar* variable, ConVar::Value oldValue )
+  {
+    fEnabled = variable->getBool();
+
+    return true;
+  }
+
+  void Profiler::callbackDump( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    wstring filename = ( arguments.size() > 1 ? arguments[1] : cProfilerDefaultDump );
+
+    if ( dump( filename ) )
+      console->printf( Console::srcEngine,
+        L"Wrote profile to %s", filename.c_str() );
+    else
+      console->errorPrintf( Console::srcEngine,
+        L"Failed to write profile to %s", filename.c_str() );
+  }
+
+}
\ No newline at end of file
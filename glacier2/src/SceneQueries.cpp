@@ -0,0 +1,217 @@
+#include "StdAfx.h"
+#include "SceneQueries.h"
+#include "PhysicsScene.h"
+#include "World.h"
+#include "Engine.h"
+#include "Exception.h"
+#include "GlacierMath.h"
+#include "Profiler.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  using namespace physx;
+
+  ENGINE_DECLARE_CONCMD( px_queries,
+    L"Print batched scene query statistics.", SceneQueries::callbackStats );
+
+  template <class HitType>
+  inline void storeHit( SceneQueryResult& result, const bool hit, const HitType& block )
+  {
+    result.hit = hit;
+    if ( !hit )
+    {
+      result.position = Vector3::ZERO;
+      result.normal = Vector3::ZERO;
+      result.distance = 0.0f;
+      result.actor = nullptr;
+      return;
+    }
+    result.position = Math::pxVec3ToOgre( block.position );
+    result.normal = Math::pxVec3ToOgre( block.normal );
+    result.distance = block.distance;
+    result.actor = block.actor;
+  }
+
+  SceneQueries::SceneQueries( PxScene* scene ): mScene( scene ),
+  mBatch( nullptr ), mRequestCount( 0 ), mSerial( 1 )
+  {
+    QueryPerformanceFrequency( &mFrequency );
+    memset( &mStats, 0, sizeof( mStats ) );
+
+    mRaycastResults.resize( cMaxSceneQueries );
+    mSweepResults.resize( cMaxSceneQueries );
+    for ( auto& batch : mHistory )
+      batch.serial = 0;
+
+    PxBatchQueryDesc descriptor( cMaxSceneQueries, cMaxSceneQueries, 0 );
+    descriptor.queryMemory.userRaycastResultBuffer = mRaycastResults.data();
+    descriptor.queryMemory.userSweepResultBuffer = mSweepResults.data();
+
+    if ( !descriptor.isValid() )
+      ENGINE_EXCEPT( "Invalid batch query descriptor" );
+
+    mBatch = mScene->createBatchQuery( descriptor );
+    if ( !mBatch )
+      ENGINE_EXCEPT( "Could not create batch query" );
+  }
+
+  SceneQueryTicket SceneQueries::enqueue( const Request& request )
+  {
+    // Overflowing requests only bump the count, execute clamps it
+    auto index = mRequestCount.fetch_add( 1, std::memory_order_relaxed );
+    if ( index >= cMaxSceneQueries )
+      return cInvalidSceneQuery;
+
+    mRequests[index] = request;
+
+    return ( (SceneQueryTicket)mSerial << 32 ) | index;
+  }
+
+  SceneQueryTicket SceneQueries::raycast( const Vector3& origin,
+  const Vector3& direction, const Real distance )
+  {
+    Request request;
+    request.type = Request_Raycast;
+    request.origin = Math::ogreVec3ToPx( origin );
+    request.direction = Math::ogreVec3ToPx( direction.normalisedCopy() );
+    request.distance = distance;
+    request.radius = 0.0f;
+
+    return enqueue( request );
+  }
+
+  SceneQueryTicket SceneQueries::sweepSphere( const Vector3& origin,
+  const Real radius, const Vector3& direction, const Real distance )
+  {
+    Request request;
+    request.type = Request_SweepSphere;
+    request.origin = Math::ogreVec3ToPx( origin );
+    request.direction = Math::ogreVec3ToPx( direction.normalisedCopy() );
+    request.distance = distance;
+    request.radius = radius;
+
+    return enqueue( request );
+  }
+
+  const bool SceneQueries::isPending( const SceneQueryTicket ticket ) const
+  {
+    return ( ticket != cInvalidSceneQuery && (uint32_t)( ticket >> 32 ) == mSerial );
+  }
+
+  const bool SceneQueries::getResult( const SceneQueryTicket ticket,
+  SceneQueryResult& result ) const
+  {
+    auto serial = (uint32_t)( ticket >> 32 );
+    auto index = (uint32_t)ticket;
+    if ( ticket == cInvalidSceneQuery )
+      return false;
+
+    // Pending tickets never match, their slot still holds an older batch
+    auto& batch = mHistory[serial & ( cSceneQueryHistory - 1 )];
+    if ( batch.serial != serial || index >= batch.results.size() )
+      return false;
+
+    result = batch.results[index];
+
+    return true;
+  }
+
+  void SceneQueries::execute()
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter( &start );
+
+    auto requested = mRequestCount.load( std::memory_order_acquire );
+    auto count = std::min( requested, cMaxSceneQueries );
+
+    mStats.raycasts = 0;
+    mStats.sweeps = 0;
+    mStats.dropped = requested - count;
+
+    // Recycle the oldest batch's storage for this one
+    auto& batch = mHistory[mSerial & ( cSceneQueryHistory - 1 )];
+    batch.results.resize( count );
+
+    if ( count > 0 )
+    {
+      const PxHitFlags flags = PxHitFlag::eDEFAULT;
+      PxQueryFilterData filter( PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC );
+
+      // The request index rides along as user data to map results back
+      for ( uint32_t i = 0; i < count; i++ )
+      {
+        auto& request = mRequests[i];
+        if ( request.type == Request_Raycast )
+        {
+          mBatch->raycast( request.origin, request.direction, request.distance,
+            0, flags, filter, (void*)(size_t)i );
+          mStats.raycasts++;
+        }
+        else
+        {
+          mBatch->sweep( PxSphereGeometry( request.radius ),
+            PxTransform( request.origin ), request.direction, request.distance,
+            0, flags, filter, (void*)(size_t)i );
+          mStats.sweeps++;
+        }
+      }
+
+      mBatch->execute();
+
+      for ( uint32_t i = 0; i < mStats.raycasts; i++ )
+      {
+        auto& query = mRaycastResults[i];
+        storeHit( batch.results[(size_t)query.userData],
+          ( query.queryStatus == PxBatchQueryStatus::eSUCCESS && query.hasBlock ),
+          query.block );
+      }
+      for ( uint32_t i = 0; i < mStats.sweeps; i++ )
+      {
+        auto& query = mSweepResults[i];
+        storeHit( batch.results[(size_t)query.userData],
+          ( query.queryStatus == PxBatchQueryStatus::eSUCCESS && query.hasBlock ),
+          query.block );
+      }
+    }
+
+    // Tickets of the batch just run become readable, new ones go to the next
+    batch.serial = mSerial;
+    if ( ++mSerial == 0 )
+      mSerial = 1;
+    mRequestCount.store( 0, std::memory_order_release );
+
+    QueryPerformanceCounter( &end );
+    mStats.batches++;
+    mStats.queries += count;
+    mStats.duration = (float)( (double)( end.QuadPart - start.QuadPart ) * 1000.0
+      / (double)mFrequency.QuadPart );
+  }
+
+  SceneQueries::~SceneQueries()
+  {
+    SAFE_RELEASE_PHYSX( mBatch );
+  }
+
+  void SceneQueries::callbackStats( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getWorld() || !gEngine->getWorld()->getPhysics() )
+      return;
+
+    auto queries = gEngine->getWorld()->getPhysics()->getQueries();
+    auto& stats = queries->mStats;
+
+    console->printf( Console::srcEngine,
+      L"Last batch: %u raycasts, %u sweeps, %u dropped, %.3fms",
+      stats.raycasts, stats.sweeps, stats.dropped, stats.duration );
+    console->printf( Console::srcEngine,
+      L"Total: %I64u batches, %I64u queries",
+      stats.batches, stats.queries );
+  }
+
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Engine.h"
 #include "Console.h"
 #include "JSUtil.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -117,6 +118,8 @@ namespace Glacier {
 
   bool Script::execute()
   {
+    GLACIER_PROFILE_FUNCTION();
+
     v8::Isolate* isolate = mHost.getIsolate();
 
     if ( mScript.IsEmpty() )
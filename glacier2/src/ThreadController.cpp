@@ -1,24 +1,88 @@
 #include "StdAfx.h"
 #include "ThreadController.h"
+#include "Profiler.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
 
 namespace Glacier {
 
-  ThreadController::ThreadController():
-  mThread( NULL ), mThreadID( 0 ), mRunEvent( NULL ), mStopEvent( NULL )
+  ENGINE_DECLARE_CONCMD( threads,
+    L"List engine threads with their step counts & CPU usage.",
+    ThreadController::callbackThreads );
+
+  vector<ThreadController*> ThreadController::fControllers;
+  Platform::RWLock ThreadController::fControllersLock;
+
+  inline ULONGLONG fileTimeToULL( const FILETIME& time )
+  {
+    return ( (ULONGLONG)time.dwHighDateTime << 32 ) | time.dwLowDateTime;
+  }
+
+  ThreadController::ThreadController( const string& name, StepMode mode ):
+  mName( name ), mMode( mode ), mThread( NULL ), mThreadID( 0 ),
+  mRunEvent( NULL ), mStopEvent( NULL ), mWakeEvent( NULL ), mTimer( NULL ),
+  mPeriod( 0 ), mSteps( 0 ), mWakeups( 0 ), mStartTick( 0 ), mStopTick( 0 ),
+  mUserTime( 0 ), mKernelTime( 0 )
   {
     mRunEvent  = CreateEventW( NULL, TRUE, FALSE, NULL );
     mStopEvent = CreateEventW( NULL, TRUE, FALSE, NULL );
-    if ( !mRunEvent || !mStopEvent )
+    mWakeEvent = CreateEventW( NULL, FALSE, FALSE, NULL );
+    if ( !mRunEvent || !mStopEvent || !mWakeEvent )
       ENGINE_EXCEPT_WINAPI( "Could not create control events" );
+
+    ScopedRWLock lock( &fControllersLock );
+    fControllers.push_back( this );
+  }
+
+  void ThreadController::setPeriod( DWORD milliseconds )
+  {
+    mPeriod = milliseconds;
+  }
+
+  void ThreadController::addWakeSource( HANDLE handle )
+  {
+    mWakeSources.push_back( handle );
+  }
+
+  void ThreadController::wake()
+  {
+    SetEvent( mWakeEvent );
   }
 
   void ThreadController::start()
   {
     stop();
 
+    mWaitHandles.clear();
+    mWaitHandles.push_back( mStopEvent );
+    if ( mMode == Step_OnWake )
+    {
+      mWaitHandles.push_back( mWakeEvent );
+      if ( mPeriod > 0 )
+      {
+        mTimer = CreateWaitableTimerW( NULL, FALSE, NULL );
+        if ( !mTimer )
+          ENGINE_EXCEPT_WINAPI( "Could not create step timer" );
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)mPeriod * 10000;
+        if ( !SetWaitableTimer( mTimer, &due, (LONG)mPeriod, NULL, NULL, FALSE ) )
+          ENGINE_EXCEPT_WINAPI( "Could not set step timer" );
+        mWaitHandles.push_back( mTimer );
+      }
+      mWaitHandles.insert( mWaitHandles.end(),
+        mWakeSources.begin(), mWakeSources.end() );
+      if ( mWaitHandles.size() > MAXIMUM_WAIT_OBJECTS )
+        ENGINE_EXCEPT( "Too many thread wake sources" );
+    }
+
+    mSteps = 0;
+    mWakeups = 0;
+    mUserTime = 0;
+    mKernelTime = 0;
+    mStartTick = GetTickCount64();
+    mStopTick = 0;
+
     mThread = CreateThread( NULL, NULL, threadProc, this, CREATE_SUSPENDED, &mThreadID );
     if ( !mThread )
       ENGINE_EXCEPT_WINAPI( "Could not create thread" );
@@ -51,41 +115,125 @@ namespace Glacier {
     auto controller = (ThreadController*)argument;
     try
     {
+      if ( !controller->mName.empty() )
+      {
+        Utilities::debugSetThreadName( GetCurrentThreadId(), controller->mName );
+        Profiler::setThreadName( controller->mName );
+      }
       controller->onStart();
       SetEvent( controller->mRunEvent );
-      while ( WaitForSingleObject( controller->mStopEvent, 0 ) != WAIT_OBJECT_0 )
+
+      // Continuous threads only poll the stop event,
+      // wake-driven ones sleep on it along with their wake sources
+      DWORD timeout = ( controller->mMode == Step_OnWake ? INFINITE : 0 );
+      auto& handles = controller->mWaitHandles;
+      while ( true )
       {
+        DWORD wait = WaitForMultipleObjects( (DWORD)handles.size(),
+          handles.data(), FALSE, timeout );
+        if ( wait == WAIT_OBJECT_0 )
+          break;
+        else if ( wait == WAIT_FAILED )
+          ENGINE_EXCEPT_WINAPI( "Wait for thread wakeup failed" );
+        else if ( wait != WAIT_TIMEOUT )
+          controller->mWakeups++;
         controller->onStep();
+        controller->mSteps++;
       }
       controller->onStop();
     }
     catch ( ... )
     {
       controller->onStop();
+      Profiler::releaseThread();
       return EXIT_FAILURE;
     }
+    Profiler::releaseThread();
     return EXIT_SUCCESS;
   }
 
+  void ThreadController::captureTimes()
+  {
+    FILETIME creation, exit, kernel, user;
+    if ( GetThreadTimes( mThread, &creation, &exit, &kernel, &user ) )
+    {
+      mUserTime = fileTimeToULL( user );
+      mKernelTime = fileTimeToULL( kernel );
+    }
+  }
+
+  void ThreadController::getCPUTime( GameTime& user, GameTime& kernel )
+  {
+    if ( mThread )
+      captureTimes();
+
+    user = (GameTime)mUserTime / 10000000.0;
+    kernel = (GameTime)mKernelTime / 10000000.0;
+  }
+
   void ThreadController::stop()
   {
-    if ( mStopEvent )
+    if ( mThread )
     {
       onPreStop();
       SetEvent( mStopEvent );
       WaitForSingleObject( mThread, INFINITE );
+      captureTimes();
+      mStopTick = GetTickCount64();
+      SAFE_CLOSE_HANDLE( mThread );
+    }
+    if ( mTimer )
+    {
+      CancelWaitableTimer( mTimer );
+      SAFE_CLOSE_HANDLE( mTimer );
     }
     ResetEvent( mRunEvent );
     ResetEvent( mStopEvent );
+    ResetEvent( mWakeEvent );
   }
 
   ThreadController::~ThreadController()
   {
+    {
+      ScopedRWLock lock( &fControllersLock );
+      fControllers.erase( std::remove( fControllers.begin(),
+        fControllers.end(), this ), fControllers.end() );
+    }
     stop();
     if ( mRunEvent )
       CloseHandle( mRunEvent );
     if ( mStopEvent )
       CloseHandle( mStopEvent );
+    if ( mWakeEvent )
+      CloseHandle( mWakeEvent );
+  }
+
+  void ThreadController::callbackThreads( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    ScopedRWLock lock( &fControllersLock, false );
+
+    console->printf( Console::srcEngine, L"Threads: %d", (int)fControllers.size() );
+
+    for ( auto controller : fControllers )
+    {
+      GameTime user, kernel;
+      controller->getCPUTime( user, kernel );
+
+      bool running = ( controller->mThread != NULL );
+      auto wall = (GameTime)( ( running ? GetTickCount64() : controller->mStopTick )
+        - controller->mStartTick ) / 1000.0;
+      auto usage = ( wall > 0.0 ? ( user + kernel ) / wall * 100.0 : 0.0 );
+
+      wstring name( controller->mName.begin(), controller->mName.end() );
+      console->printf( Console::srcEngine,
+        L"  %s (%u): %s, %s, %I64u steps, %I64u wakeups, cpu %.1fms user %.1fms kernel (%.1f%%)",
+        name.empty() ? L"unnamed" : name.c_str(), controller->mThreadID,
+        running ? L"running" : L"stopped",
+        controller->mMode == Step_OnWake ? L"wake-driven" : L"continuous",
+        controller->mSteps.load(), controller->mWakeups.load(),
+        user * 1000.0, kernel * 1000.0, usage );
+    }
   }
 
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "StdAfx.h"
+#include "ThreadPlacement.h"
+#include "Engine.h"
+#include "Console.h"
+#include "Exception.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  const wchar_t* cThreadPolicyNames[ThreadPlacement::Policy_Count] = {
+    L"none", L"main", L"spread", L"compact"
+  };
+
+  const wchar_t* cThreadRoleNames[ThreadPlacement::Role_Count] = {
+    L"main", L"physics", L"worker", L"io"
+  };
+
+  ENGINE_DECLARE_CONVAR( eng_threadpolicy,
+    L"Thread placement policy. 0 = none, 1 = main thread only, 2 = spread over L3 groups, 3 = compact. Applied on restart.", 2 );
+  ENGINE_DECLARE_CONCMD( thread_layout,
+    L"Print CPU topology and engine thread placement.",
+    ThreadPlacement::callbackLayout );
+
+  ThreadPlacement::ThreadPlacement( Engine* engine, uint32_t physicsThreads ):
+  mEngine( engine ), mPolicy( Policy_Spread ), mCacheGroups( 0 ),
+  mLogicalCount( 0 ), mMainMask( 0 ), mPhysicsThreads( physicsThreads )
+  {
+    int policy = g_CVar_eng_threadpolicy.getInt();
+    if ( policy >= Policy_None && policy < Policy_Count )
+      mPolicy = (Policy)policy;
+
+    readTopology();
+    plan();
+  }
+
+  void ThreadPlacement::readTopology()
+  {
+    DWORD_PTR processMask, systemMask;
+    if ( !GetProcessAffinityMask( GetCurrentProcess(), &processMask, &systemMask ) )
+      processMask = 1;
+
+    DWORD length = 0;
+    GetLogicalProcessorInformation( nullptr, &length );
+    vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(
+      length / sizeof( SYSTEM_LOGICAL_PROCESSOR_INFORMATION ) );
+    if ( info.empty() || !GetLogicalProcessorInformation( info.data(), &length ) )
+    {
+      // No topology, treat every logical processor as a core
+      mEngine->getConsole()->errorPrintf( Console::srcEngine,
+        L"Could not query CPU topology - assuming no SMT" );
+      for ( uint32_t i = 0; i < sizeof( DWORD_PTR ) * 8; i++ )
+      {
+        DWORD_PTR mask = (DWORD_PTR)1 << i;
+        if ( processMask & mask )
+        {
+          Core core = { mask, 0 };
+          mCores.push_back( core );
+        }
+      }
+      mCacheGroups = 1;
+      mLogicalCount = (uint32_t)mCores.size();
+      return;
+    }
+
+    vector<DWORD_PTR> caches;
+    for ( auto& entry : info )
+      if ( entry.Relationship == RelationCache && entry.Cache.Level == 3 )
+        caches.push_back( entry.ProcessorMask );
+
+    for ( auto& entry : info )
+    {
+      if ( entry.Relationship != RelationProcessorCore )
+        continue;
+      DWORD_PTR mask = ( entry.ProcessorMask & processMask );
+      if ( !mask )
+        continue;
+      Core core = { mask, 0 };
+      for ( uint32_t i = 0; i < caches.size(); i++ )
+        if ( caches[i] & mask )
+          core.cache = i;
+      mCores.push_back( core );
+      mLogicalCount += Utilities::hammingWeight64( mask );
+    }
+
+    mCacheGroups = std::max( (uint32_t)caches.size(), 1U );
+
+    if ( mCores.empty() )
+    {
+      Core core = { processMask, 0 };
+      mCores.push_back( core );
+      mLogicalCount = Utilities::hammingWeight64( processMask );
+    }
+  }
+
+  void ThreadPlacement::plan()
+  {
+    // The main thread keeps the first core, as it always has
+    auto& main = mCores[0];
+    mMainMask = main.mask;
+
+    if ( mPolicy == Policy_Spread )
+    {
+      // Round-robin over L3 groups, starting from the main thread's
+      vector<vector<DWORD_PTR>> groups( mCacheGroups );
+      for ( size_t i = 1; i < mCores.size(); i++ )
+        groups[mCores[i].cache].push_back( mCores[i].mask );
+      for ( size_t depth = 0; mOrder.size() < mCores.size() - 1; depth++ )
+      {
+        for ( uint32_t i = 0; i < mCacheGroups; i++ )
+        {
+          auto& group = groups[( main.cache + i ) % mCacheGroups];
+          if ( depth < group.size() )
+            mOrder.push_back( group[depth] );
+        }
+      }
+    }
+    else
+    {
+      // Main thread's L3 group first, then the rest in order
+      for ( size_t i = 1; i < mCores.size(); i++ )
+        if ( mCores[i].cache == main.cache )
+          mOrder.push_back( mCores[i].mask );
+      for ( size_t i = 1; i < mCores.size(); i++ )
+        if ( mCores[i].cache != main.cache )
+          mOrder.push_back( mCores[i].mask );
+    }
+  }
+
+  DWORD_PTR ThreadPlacement::getMask( Role role, uint32_t index )
+  {
+    if ( mPolicy == Policy_None )
+      return 0;
+
+    if ( mPolicy == Policy_Main )
+    {
+      // Lowest logical processor of the first core
+      return ( role == Role_Main ? ( mMainMask & ( ~mMainMask + 1 ) ) : 0 );
+    }
+
+    if ( role == Role_Main )
+      return mMainMask;
+
+    // Single core machines have nowhere else to go
+    if ( mOrder.empty() )
+      return mMainMask;
+
+    if ( role == Role_IO )
+    {
+      DWORD_PTR mask = 0;
+      for ( auto core : mOrder )
+        mask |= core;
+      return mask;
+    }
+
+    // Physics threads take the first cores, workers continue after them
+    // and wrap around once every core has a thread
+    uint32_t slot = ( role == Role_Physics ? index : mPhysicsThreads + index );
+    return mOrder[slot % mOrder.size()];
+  }
+
+  void ThreadPlacement::place( HANDLE thread, DWORD threadID, Role role,
+  uint32_t index, const wstring& name )
+  {
+    DWORD_PTR mask = getMask( role, index );
+    if ( mask && !SetThreadAffinityMask( thread, mask ) )
+    {
+      mEngine->getConsole()->errorPrintf( Console::srcEngine,
+        L"Failed to set thread affinity mask for %s", name.c_str() );
+      mask = 0;
+    }
+
+    ScopedRWLock lock( &mLock );
+    Assignment assignment = { name, role, threadID, mask };
+    mLayout.push_back( assignment );
+  }
+
+  void ThreadPlacement::callbackLayout( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getPlacement() )
+      return;
+
+    auto placement = gEngine->getPlacement();
+
+    uint32_t smt = 0;
+    for ( auto& core : placement->mCores )
+      if ( Utilities::hammingWeight64( core.mask ) > 1 )
+        smt++;
+
+    console->printf( Console::srcEngine,
+      L"Topology: %d physical cores (%d with SMT), %d logical, %d L3 groups",
+      (int)placement->mCores.size(), smt, placement->mLogicalCount,
+      placement->mCacheGroups );
+
+    for ( size_t i = 0; i < placement->mCores.size(); i++ )
+      console->printf( Console::srcEngine,
+        L"  core %d: mask 0x%I64x, L3 group %d",
+        (int)i, (uint64_t)placement->mCores[i].mask, placement->mCores[i].cache );
+
+    console->printf( Console::srcEngine,
+      L"Policy: %s", cThreadPolicyNames[placement->mPolicy] );
+
+    ScopedRWLock lock( &placement->mLock, false );
+    for ( auto& assignment : placement->mLayout )
+    {
+      if ( assignment.mask )
+        console->printf( Console::srcEngine,
+          L"  %s (%s, %u): mask 0x%I64x",
+          assignment.name.c_str(), cThreadRoleNames[assignment.role],
+          assignment.threadID, (uint64_t)assignment.mask );
+      else
+        console->printf( Console::srcEngine,
+          L"  %s (%s, %u): unrestricted",
+          assignment.name.c_str(), cThreadRoleNames[assignment.role],
+          assignment.threadID );
+    }
+  }
+
+}
\ No newline at end of file
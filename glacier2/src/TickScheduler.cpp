@@ -0,0 +1,131 @@
+#include "StdAfx.h"
+#include "TickScheduler.h"
+#include "Engine.h"
+#include "Console.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! Upper bound for the number of base steps considered when staggering.
+  const uint32_t cMaxScheduleWindow = 720;
+
+  inline uint64_t greatestCommonDivisor( uint64_t a, uint64_t b )
+  {
+    while ( b )
+    {
+      uint64_t t = a % b;
+      a = b;
+      b = t;
+    }
+    return a;
+  }
+
+  ENGINE_DECLARE_CONCMD( sched_info,
+    L"Print tick scheduler slots.", TickScheduler::callbackInfo );
+
+  TickScheduler::TickScheduler( Engine* engine ): mEngine( engine ),
+  mBaseStep( 1.0 / 60.0 ), mStep( 0 )
+  {
+    //
+  }
+
+  void TickScheduler::addSlot( size_t id, const wstring& name, ConVar* rate )
+  {
+    if ( id >= mSlots.size() )
+      mSlots.resize( id + 1 );
+
+    mSlots[id].name = name;
+    mSlots[id].rate = rate;
+
+    configure( mBaseStep );
+  }
+
+  void TickScheduler::configure( GameTime baseStep )
+  {
+    mBaseStep = baseStep;
+
+    // Round every rate to a whole number of base steps
+    uint64_t window = 1;
+    for ( auto& slot : mSlots )
+    {
+      slot.divisor = 1;
+      slot.phase = 0;
+      slot.rateCache = ( slot.rate ? slot.rate->getInt() : 0 );
+      if ( slot.rateCache > 0 )
+      {
+        GameTime steps = 1.0 / ( (GameTime)slot.rateCache * mBaseStep );
+        slot.divisor = std::max( (uint32_t)( steps + 0.5 ), (uint32_t)1 );
+      }
+      window = ( window / greatestCommonDivisor( window, slot.divisor ) ) * slot.divisor;
+    }
+    window = std::min( window, (uint64_t)cMaxScheduleWindow );
+
+    // Greedily place each slot on the phase with the least load
+    vector<uint32_t> load( (size_t)window, 0 );
+    for ( auto& slot : mSlots )
+    {
+      uint32_t bestLoad = UINT_MAX;
+      for ( uint32_t phase = 0; phase < slot.divisor; phase++ )
+      {
+        uint32_t peak = 0;
+        for ( size_t step = phase; step < load.size(); step += slot.divisor )
+          peak = std::max( peak, load[step] );
+        if ( peak < bestLoad )
+        {
+          bestLoad = peak;
+          slot.phase = phase;
+        }
+      }
+      for ( size_t step = slot.phase; step < load.size(); step += slot.divisor )
+        load[step]++;
+    }
+  }
+
+  bool TickScheduler::isDirty()
+  {
+    for ( auto& slot : mSlots )
+      if ( slot.rate && slot.rate->getInt() != slot.rateCache )
+        return true;
+
+    return false;
+  }
+
+  bool TickScheduler::isDue( size_t id, GameTime& tick )
+  {
+    auto& slot = mSlots[id];
+    if ( mStep % slot.divisor != slot.phase )
+      return false;
+
+    tick = mBaseStep * (GameTime)slot.divisor;
+    slot.ticks++;
+
+    return true;
+  }
+
+  void TickScheduler::advance()
+  {
+    mStep++;
+
+    if ( isDirty() )
+      configure( mBaseStep );
+  }
+
+  void TickScheduler::callbackInfo( Console* console, ConCmd* command,
+  StringVector& arguments )
+  {
+    if ( !gEngine || !gEngine->getScheduler() )
+      return;
+
+    auto scheduler = gEngine->getScheduler();
+    console->printf( Console::srcEngine, L"Base step: %.2fHz",
+      1.0 / scheduler->mBaseStep );
+    for ( auto& slot : scheduler->mSlots )
+      console->printf( Console::srcEngine,
+        L"%s: %.2fHz (divisor %d, phase %d), %I64u ticks",
+        slot.name.c_str(), 1.0 / ( scheduler->mBaseStep * slot.divisor ),
+        slot.divisor, slot.phase, slot.ticks );
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "StdAfx.h"
+#include "TransformStore.h"
+#include "Entity.h"
+#include "Engine.h"
+#include "JobSystem.h"
+#include "Exception.h"
+#include "Profiler.h"
+
+// Glacier² Game Engine © 2014 noorus
+// All rights reserved.
+
+namespace Glacier {
+
+  //! Moving list index of a slot waiting in a deferred list.
+  const uint32_t cDeferredMoveIndex = cInvalidEntityIndex - 1;
+
+  TransformStore::TransformStore(): mDeferring( false )
+  {
+    //
+  }
+
+  uint32_t TransformStore::allocate( uint32_t* owner )
+  {
+    auto slot = (uint32_t)mFlags.size();
+
+    for ( int i = 0; i < 3; i++ )
+    {
+      mPosition[i].push_back( 0.0f );
+      mPrevPosition[i].push_back( 0.0f );
+    }
+    const float identity[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    for ( int i = 0; i < 4; i++ )
+    {
+      mOrientation[i].push_back( identity[i] );
+      mPrevOrientation[i].push_back( identity[i] );
+    }
+
+    mFlags.push_back( Flag_SyncPosition | Flag_SyncOrientation );
+    mNodes.push_back( nullptr );
+    mActors.push_back( nullptr );
+    mOwners.push_back( owner );
+    mMovingIndex.push_back( cInvalidEntityIndex );
+    *owner = slot;
+
+    return slot;
+  }
+
+  void TransformStore::reserve( size_t count )
+  {
+    for ( int i = 0; i < 3; i++ )
+    {
+      mPosition[i].reserve( count );
+      mPrevPosition[i].reserve( count );
+    }
+    for ( int i = 0; i < 4; i++ )
+    {
+      mOrientation[i].reserve( count );
+      mPrevOrientation[i].reserve( count );
+    }
+    mFlags.reserve( count );
+    mNodes.reserve( count );
+    mActors.reserve( count );
+    mOwners.reserve( count );
+    mMovingIndex.reserve( count );
+  }
+
+  template <typename T>
+  inline void swapRemove( vector<T>& array, uint32_t slot )
+  {
+    array[slot] = array.back();
+    array.pop_back();
+  }
+
+  void TransformStore::markDirty( uint32_t slot )
+  {
+    mFlags[slot] |= Flag_Dirty;
+    if ( mMovingIndex[slot] != cInvalidEntityIndex )
+      return;
+
+    // Job threads only write their own entity's slot, but share the list
+    if ( mDeferring )
+    {
+      auto index = gEngine->getJobs()->getThreadIndex();
+      if ( index < 0 || (size_t)index >= mDeferredMoves.size() )
+        ENGINE_EXCEPT( "Transform written from outside the job system" );
+      mMovingIndex[slot] = cDeferredMoveIndex;
+      mDeferredMoves[index].push_back( slot );
+      return;
+    }
+
+    mMovingIndex[slot] = (uint32_t)mMoving.size();
+    mMoving.push_back( slot );
+  }
+
+  void TransformStore::beginDeferring( size_t threads )
+  {
+    assert( !mDeferring );
+    if ( mDeferredMoves.size() != threads )
+      mDeferredMoves.resize( threads );
+    mDeferring = true;
+  }
+
+  void TransformStore::endDeferring()
+  {
+    assert( mDeferring );
+    mDeferring = false;
+    for ( auto& moves : mDeferredMoves )
+    {
+      for ( auto slot : moves )
+      {
+        mMovingIndex[slot] = (uint32_t)mMoving.size();
+        mMoving.push_back( slot );
+      }
+      moves.clear();
+    }
+  }
+
+  void TransformStore::unlist( uint32_t slot )
+  {
+    auto index = mMovingIndex[slot];
+    if ( index == cInvalidEntityIndex )
+      return;
+
+    auto last = mMoving.back();
+    mMoving[index] = last;
+    mMovingIndex[last] = index;
+    mMoving.pop_back();
+    mMovingIndex[slot] = cInvalidEntityIndex;
+  }
+
+  void TransformStore::release( uint32_t slot )
+  {
+    unlist( slot );
+    if ( mActors[slot] )
+      mActors[slot]->userData = nullptr;
+
+    for ( int i = 0; i < 3; i++ )
+    {
+      swapRemove( mPosition[i], slot );
+      swapRemove( mPrevPosition[i], slot );
+    }
+    for ( int i = 0; i < 4; i++ )
+    {
+      swapRemove( mOrientation[i], slot );
+      swapRemove( mPrevOrientation[i], slot );
+    }
+    swapRemove( mFlags, slot );
+    swapRemove( mNodes, slot );
+    swapRemove( mActors, slot );
+    swapRemove( mOwners, slot );
+    swapRemove( mMovingIndex, slot );
+
+    // The last slot moved into our place
+    if ( slot < mOwners.size() )
+    {
+      *mOwners[slot] = slot;
+      if ( mMovingIndex[slot] != cInvalidEntityIndex )
+        mMoving[mMovingIndex[slot]] = slot;
+    }
+  }
+
+  const Vector3 TransformStore::getPosition( uint32_t slot ) const
+  {
+    return Vector3( mPosition[0][slot], mPosition[1][slot], mPosition[2][slot] );
+  }
+
+  const Quaternion TransformStore::getOrientation( uint32_t slot ) const
+  {
+    return Quaternion( mOrientation[0][slot], mOrientation[1][slot],
+      mOrientation[2][slot], mOrientation[3][slot] );
+  }
+
+  void TransformStore::setPosition( uint32_t slot, const Vector3& position )
+  {
+    mPosition[0][slot] = position.x;
+    mPosition[1][slot] = position.y;
+    mPosition[2][slot] = position.z;
+    markDirty( slot );
+  }
+
+  void TransformStore::setOrientation( uint32_t slot, const Quaternion& orientation )
+  {
+    mOrientation[0][slot] = orientation.w;
+    mOrientation[1][slot] = orientation.x;
+    mOrientation[2][slot] = orientation.y;
+    mOrientation[3][slot] = orientation.z;
+    markDirty( slot );
+  }
+
+  const Vector3 TransformStore::getInterpolatedPosition( uint32_t slot,
+  GameTime alpha ) const
+  {
+    auto previous = Vector3( mPrevPosition[0][slot], mPrevPosition[1][slot], mPrevPosition[2][slot] );
+    return previous + ( getPosition( slot ) - previous ) * (Real)alpha;
+  }
+
+  const Quaternion TransformStore::getInterpolatedOrientation( uint32_t slot,
+  GameTime alpha ) const
+  {
+    auto previous = Quaternion( mPrevOrientation[0][slot], mPrevOrientation[1][slot],
+      mPrevOrientation[2][slot], mPrevOrientation[3][slot] );
+    return Quaternion::nlerp( (Real)alpha, previous, getOrientation( slot ), true );
+  }
+
+  void TransformStore::setNode( uint32_t slot, SceneNode* node, uint8_t syncFlags )
+  {
+    mNodes[slot] = node;
+    mFlags[slot] = ( mFlags[slot] & ~( Flag_SyncPosition | Flag_SyncOrientation ) )
+      | ( syncFlags & ( Flag_SyncPosition | Flag_SyncOrientation ) );
+    markDirty( slot );
+  }
+
+  void TransformStore::setActor( uint32_t slot, physx::PxRigidActor* actor )
+  {
+    if ( mActors[slot] )
+      mActors[slot]->userData = nullptr;
+
+    mActors[slot] = actor;
+    if ( actor )
+      actor->userData = mOwners[slot];
+  }
+
+  void TransformStore::storePrevious( uint32_t slot )
+  {
+    for ( int i = 0; i < 3; i++ )
+      mPrevPosition[i][slot] = mPosition[i][slot];
+    for ( int i = 0; i < 4; i++ )
+      mPrevOrientation[i][slot] = mOrientation[i][slot];
+    markDirty( slot );
+  }
+
+  void TransformStore::storePrevious()
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    // Slots off the list have had equal current & previous transforms
+    // since they were last stored
+    for ( size_t i = mMoving.size(); i > 0; i-- )
+    {
+      auto slot = mMoving[i - 1];
+
+      for ( int c = 0; c < 3; c++ )
+        mPrevPosition[c][slot] = mPosition[c][slot];
+      for ( int c = 0; c < 4; c++ )
+        mPrevOrientation[c][slot] = mOrientation[c][slot];
+
+      // Last step's dirty bit becomes the moved bit, so that nodes are
+      // synced once more after a transform settles, and then dropped
+      auto flags = mFlags[slot];
+      if ( !( flags & Flag_Dirty ) )
+      {
+        mFlags[slot] = (uint8_t)( flags & ~Flag_Moved );
+        unlist( slot );
+      }
+      else
+        mFlags[slot] = (uint8_t)( ( flags & ~Flag_Dirty ) | Flag_Moved );
+    }
+  }
+
+  void TransformStore::readPhysics( const vector<physx::PxActiveTransform>& transforms )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    for ( size_t i = 0; i < transforms.size(); i++ )
+    {
+      auto owner = (const uint32_t*)transforms[i].userData;
+      if ( !owner )
+        continue;
+
+      auto slot = *owner;
+      const physx::PxTransform& pose = transforms[i].actor2World;
+      mPosition[0][slot] = pose.p.x;
+      mPosition[1][slot] = pose.p.y;
+      mPosition[2][slot] = pose.p.z;
+      mOrientation[0][slot] = pose.q.w;
+      mOrientation[1][slot] = pose.q.x;
+      mOrientation[2][slot] = pose.q.y;
+      mOrientation[3][slot] = pose.q.z;
+      markDirty( slot );
+    }
+  }
+
+  void TransformStore::sync( GameTime alpha )
+  {
+    GLACIER_PROFILE_FUNCTION();
+
+    const float t = (float)alpha;
+
+    for ( auto slot : mMoving )
+    {
+      auto node = mNodes[slot];
+      if ( !node )
+        continue;
+
+      auto flags = mFlags[slot];
+
+      // Positions lerp
+      if ( flags & Flag_SyncPosition )
+      {
+        node->setPosition(
+          mPrevPosition[0][slot] + ( mPosition[0][slot] - mPrevPosition[0][slot] ) * t,
+          mPrevPosition[1][slot] + ( mPosition[1][slot] - mPrevPosition[1][slot] ) * t,
+          mPrevPosition[2][slot] + ( mPosition[2][slot] - mPrevPosition[2][slot] ) * t );
+      }
+
+      // Orientations nlerp along the shortest path
+      if ( flags & Flag_SyncOrientation )
+      {
+        float pw = mPrevOrientation[0][slot], cw = mOrientation[0][slot];
+        float px = mPrevOrientation[1][slot], cx = mOrientation[1][slot];
+        float py = mPrevOrientation[2][slot], cy = mOrientation[2][slot];
+        float pz = mPrevOrientation[3][slot], cz = mOrientation[3][slot];
+        float dot = pw * cw + px * cx + py * cy + pz * cz;
+        float sign = ( dot < 0.0f ? -1.0f : 1.0f );
+        float w = pw + ( cw * sign - pw ) * t;
+        float x = px + ( cx * sign - px ) * t;
+        float y = py + ( cy * sign - py ) * t;
+        float z = pz + ( cz * sign - pz ) * t;
+        float scale = 1.0f / sqrtf( w * w + x * x + y * y + z * z );
+        node->setOrientation( w * scale, x * scale, y * scale, z * scale );
+      }
+    }
+  }
+
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "PhysicsScene.h"
 #include "Engine.h"
 #include "Scripting.h"
+#include "TransformStore.h"
 
 // Glacier² Game Engine © 2014 noorus
 // All rights reserved.
@@ -14,12 +15,14 @@
 namespace Glacier {
 
   World::World( Engine* engine ):
-  mEntities( nullptr ), mPhysics( nullptr )
+  mEntities( nullptr ), mPhysics( nullptr ), mTransforms( nullptr )
   {
+    mTransforms = new TransformStore();
     mEntities = new EntityManager( engine, this );
     mPhysics = engine->getPhysics()->createScene();
 #ifndef GLACIER_NO_PHYSICS_DEBUG
-    mPhysics->setDebugVisuals( true );
+    if ( Locator::hasGraphics() )
+      mPhysics->setDebugVisuals( true );
 #endif
   }
 
@@ -31,6 +34,7 @@ namespace Glacier {
   World::~World()
   {
     SAFE_DELETE( mEntities );
+    SAFE_DELETE( mTransforms );
     gEngine->getPhysics()->destroyScene( mPhysics );
   }
 
@@ -32,18 +32,24 @@ namespace Glacier {
     }
 
     Plane::Plane( PhysicsScene* scene, const Ogre::Plane& plane,
-    const Real width, const Real height, const Vector3& position, const Real u, const Real v ):
-    Primitive( scene )
+    const Real width, const Real height, const Vector3& position, const Real u, const Real v,
+    const bool physical ): Primitive( scene )
     {
       PxPhysics& physics = mScene->getScene()->getPhysics();
 
-      mActor = PxCreatePlane( physics,
-        PxPlane( Glacier::Math::ogreVec3ToPx( plane.normal ), plane.d ),
-        *mScene->getDefaultMaterial() );
-      if ( !mActor )
-        ENGINE_EXCEPT( "Could not create physics plane actor" );
+      if ( physical )
+      {
+        mActor = PxCreatePlane( physics,
+          PxPlane( Glacier::Math::ogreVec3ToPx( plane.normal ), plane.d ),
+          *mScene->getDefaultMaterial() );
+        if ( !mActor )
+          ENGINE_EXCEPT( "Could not create physics plane actor" );
+
+        mScene->getScene()->addActor( *mActor );
+      }
 
-      mScene->getScene()->addActor( *mActor );
+      if ( !Locator::hasGraphics() )
+        return;
 
       Ogre::v1::MeshPtr planeMeshV1 = Ogre::v1::MeshManager::getSingleton().createPlane(
         "",
@@ -79,24 +85,32 @@ namespace Glacier {
         mNode->removeAndDestroyAllChildren();
         Locator::getGraphics().getScene()->destroySceneNode( mNode );
       }
-      mScene->getScene()->removeActor( *mActor );
+      if ( mActor )
+        mScene->getScene()->removeActor( *mActor );
     }
 
-    Box::Box( PhysicsScene* scene, const Vector3& size, const Vector3& position, const Quaternion& orientation ): Primitive( scene )
+    Box::Box( PhysicsScene* scene, const Vector3& size, const Vector3& position, const Quaternion& orientation,
+    const bool physical ): Primitive( scene )
     {
       PxPhysics& physics = mScene->getScene()->getPhysics();
 
-      PxTransform transform;
-      transform.p = Math::ogreVec3ToPx( position );
-      transform.q = Math::ogreQtToPx( orientation );
+      if ( physical )
+      {
+        PxTransform transform;
+        transform.p = Math::ogreVec3ToPx( position );
+        transform.q = Math::ogreQtToPx( orientation );
+
+        PxBoxGeometry geometry;
+        geometry.halfExtents = Math::ogreVec3ToPx( size / 2.0f );
+        mActor = PxCreateStatic( physics, transform, geometry, *scene->getDefaultMaterial() );
+        if ( !mActor )
+          ENGINE_EXCEPT( "Could not create physics box actor" );
 
-      PxBoxGeometry geometry;
-      geometry.halfExtents = Math::ogreVec3ToPx( size / 2.0f );
-      mActor = PxCreateStatic( physics, transform, geometry, *scene->getDefaultMaterial() );
-      if ( !mActor )
-        ENGINE_EXCEPT( "Could not create physics box actor" );
+        mScene->getScene()->addActor( *mActor );
+      }
 
-      mScene->getScene()->addActor( *mActor );
+      if ( !Locator::hasGraphics() )
+        return;
 
       mMesh = Procedural::BoxGenerator().setSize( size ).realizeMesh();
 
@@ -121,7 +135,8 @@ namespace Glacier {
         mNode->removeAndDestroyAllChildren();
         Locator::getGraphics().getScene()->destroySceneNode( mNode );
       }
-      mScene->getScene()->removeActor( *mActor );
+      if ( mActor )
+        mScene->getScene()->removeActor( *mActor );
     }
 
   }
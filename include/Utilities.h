@@ -1,5 +1,6 @@
 #pragma once
 #include <windows.h>
+#include <atomic>
 #include "Exception.h"
 
 // Glacier² Game Engine © 2014 noorus
@@ -94,86 +95,318 @@ namespace Glacier {
     }
   };
 
+  const size_t cCacheLineSize = 64; //!< Padding to keep hot atomics apart
+
+  //! \class SequencedRing
+  //! A bounded lock-free ring of sequenced slots, shared by the queues below.
+  //! Slots are preallocated & reused in place, and each carries a sequence
+  //! number telling producers and consumers whose turn it is, so neither
+  //! ever waits on a lock. Based on Dmitry Vyukov's bounded MPMC queue.
+  //! The positions are kept off each other's cache lines with padding
+  //! rather than alignment, so that rings may be members of heap objects.
+  template <typename T>
+  class SequencedRing: boost::noncopyable {
+  protected:
+    struct Slot {
+      std::atomic<size_t> sequence; //!< Turn counter
+      T data; //!< Payload, reused in place
+    };
+    Slot* mSlots;         //!< Slot ring
+    size_t mMask;         //!< Ring index mask
+    uint8_t mPadding0[cCacheLineSize];
+    std::atomic<size_t> mEnqueuePos; //!< Producers' position
+    uint8_t mPadding1[cCacheLineSize];
+    std::atomic<size_t> mDequeuePos; //!< Consumers' position
+    uint8_t mPadding2[cCacheLineSize];
+  public:
+    //! Constructor.
+    //! \param  capacity Capacity, rounded up to a power of two.
+    SequencedRing( size_t capacity ): mSlots( nullptr ), mMask( 0 )
+    {
+      size_t size = 2;
+      while ( size < capacity )
+        size <<= 1;
+      mMask = size - 1;
+      mSlots = new Slot[size];
+      for ( size_t i = 0; i < size; i++ )
+        mSlots[i].sequence.store( i, std::memory_order_relaxed );
+      mEnqueuePos.store( 0, std::memory_order_relaxed );
+      mDequeuePos.store( 0, std::memory_order_relaxed );
+    }
+    //! Destructor.
+    ~SequencedRing()
+    {
+      delete[] mSlots;
+    }
+    //! Gets the capacity.
+    size_t getCapacity() const
+    {
+      return mMask + 1;
+    }
+    //! Gets a slot's payload for preallocation.
+    //! Only safe before the ring is in use.
+    T& getSlot( size_t index )
+    {
+      return mSlots[index & mMask].data;
+    }
+    //! Pushes an element. Safe from any thread.
+    //! \param element The element to push.
+    //! \return false if the ring was full.
+    bool tryPush( const T& element )
+    {
+      Slot* slot;
+      size_t pos = mEnqueuePos.load( std::memory_order_relaxed );
+      while ( true )
+      {
+        slot = &mSlots[pos & mMask];
+        size_t sequence = slot->sequence.load( std::memory_order_acquire );
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if ( diff == 0 )
+        {
+          if ( mEnqueuePos.compare_exchange_weak( pos, pos + 1,
+            std::memory_order_relaxed ) )
+            break;
+        }
+        else if ( diff < 0 )
+          return false;
+        else
+          pos = mEnqueuePos.load( std::memory_order_relaxed );
+      }
+      slot->data = element;
+      slot->sequence.store( pos + 1, std::memory_order_release );
+      return true;
+    }
+    //! Pops the oldest element. Safe from any thread.
+    //! \param element Receives the popped element.
+    //! \return false if the ring was empty.
+    bool tryPop( T& element )
+    {
+      Slot* slot;
+      size_t pos = mDequeuePos.load( std::memory_order_relaxed );
+      while ( true )
+      {
+        slot = &mSlots[pos & mMask];
+        size_t sequence = slot->sequence.load( std::memory_order_acquire );
+        intptr_t diff = (intptr_t)sequence - (intptr_t)( pos + 1 );
+        if ( diff == 0 )
+        {
+          if ( mDequeuePos.compare_exchange_weak( pos, pos + 1,
+            std::memory_order_relaxed ) )
+            break;
+        }
+        else if ( diff < 0 )
+          return false;
+        else
+          pos = mDequeuePos.load( std::memory_order_relaxed );
+      }
+      element = slot->data;
+      slot->sequence.store( pos + mMask + 1, std::memory_order_release );
+      return true;
+    }
+  };
+
   //! \class SafeWaitableQueue
-  //! A thread-safe queue object with a waitable semaphore handle.
-  //! Thanks to Jim Beveridge's example for the semaphore approach.
+  //! A bounded, thread-safe multi-producer, multi-consumer queue.
+  //! Elements live in a SequencedRing, so pushes & pops never lock or
+  //! allocate. Waiting variants only touch the kernel when the queue is
+  //! empty or full and someone sleeps.
   template <typename T>
   class SafeWaitableQueue: boost::noncopyable {
   protected:
-    SRWLOCK mLock;        //!< The lock
-    HANDLE mSemaphore;    //!< Handle of the semaphore
-    std::list<T> mQueue;  //!< The queue
-    bool mOverflow;       //!< Whether we're overflowing
+    SequencedRing<T> mRing; //!< Element storage
+    std::atomic<long> mPopWaiters; //!< Consumers parked on empty, padded off the ring
+    std::atomic<long> mPushWaiters; //!< Producers parked on full
+    HANDLE mNotEmpty;     //!< Released for parked consumers
+    HANDLE mNotFull;      //!< Released for parked producers
+    volatile bool mOverflow; //!< Whether we're overflowing
+    //! Hands a wakeup to one parked waiter, if any. Each release is paid for
+    //! by taking one waiter off the count, so the semaphore is never released
+    //! for nobody. The fence orders our slot publish before the waiter check,
+    //! pairing with the waiter's increment before its last retry.
+    void wake( std::atomic<long>& waiters, HANDLE semaphore )
+    {
+      std::atomic_thread_fence( std::memory_order_seq_cst );
+      long count = waiters.load( std::memory_order_relaxed );
+      while ( count > 0 )
+      {
+        if ( waiters.compare_exchange_weak( count, count - 1,
+          std::memory_order_relaxed ) )
+        {
+          ReleaseSemaphore( semaphore, 1, NULL );
+          return;
+        }
+      }
+    }
+    //! Takes a waiter that is leaving without a wakeup off the count. If a
+    //! waker already took it off, the release it made is ours to consume.
+    void unpark( std::atomic<long>& waiters, HANDLE semaphore )
+    {
+      long count = waiters.load( std::memory_order_relaxed );
+      while ( count > 0 )
+      {
+        if ( waiters.compare_exchange_weak( count, count - 1,
+          std::memory_order_relaxed ) )
+          return;
+      }
+      WaitForSingleObject( semaphore, INFINITE );
+    }
+    //! Retries an operation, parking on the semaphore between attempts.
+    //! \return false if timed out.
+    template <typename Attempt>
+    bool park( std::atomic<long>& waiters, HANDLE semaphore,
+      DWORD milliseconds, Attempt attempt )
+    {
+      auto deadline = GetTickCount64() + milliseconds;
+      while ( true )
+      {
+        waiters.fetch_add( 1 );
+        if ( attempt() )
+        {
+          unpark( waiters, semaphore );
+          return true;
+        }
+        DWORD wait = INFINITE;
+        if ( milliseconds != INFINITE )
+        {
+          auto now = GetTickCount64();
+          wait = ( now >= deadline ? 0 : (DWORD)( deadline - now ) );
+        }
+        // A wakeup leaves us off the count, so only a timeout needs unparking
+        if ( WaitForSingleObject( semaphore, wait ) != WAIT_OBJECT_0 )
+        {
+          unpark( waiters, semaphore );
+          return attempt();
+        }
+      }
+    }
   public:
     //! Constructor.
-    //! \param  maxCount Maximum number of waitables.
-    SafeWaitableQueue( long maxCount ): mSemaphore( NULL ),
-    mOverflow( false )
+    //! \param  maxCount Capacity, rounded up to a power of two.
+    SafeWaitableQueue( long maxCount ): mRing( (size_t)maxCount ),
+    mNotEmpty( NULL ), mNotFull( NULL ), mOverflow( false )
     {
-      InitializeSRWLock( &mLock );
-      mSemaphore = CreateSemaphoreW( NULL, 0, maxCount, NULL );
+      mPopWaiters.store( 0, std::memory_order_relaxed );
+      mPushWaiters.store( 0, std::memory_order_relaxed );
+      mNotEmpty = CreateSemaphoreW( NULL, 0, LONG_MAX, NULL );
+      mNotFull = CreateSemaphoreW( NULL, 0, LONG_MAX, NULL );
+      if ( !mNotEmpty || !mNotFull )
+        ENGINE_EXCEPT_WINAPI( "Failed to create queue semaphores" );
     }
     //! Destructor.
     ~SafeWaitableQueue()
     {
-      if ( mSemaphore )
-        CloseHandle( mSemaphore );
+      if ( mNotEmpty )
+        CloseHandle( mNotEmpty );
+      if ( mNotFull )
+        CloseHandle( mNotFull );
     }
-    //! Gets the handle.
-    //! \return The handle.
-    HANDLE getHandle()
+    //! Gets the capacity.
+    size_t getCapacity()
     {
-      return mSemaphore;
+      return mRing.getCapacity();
     }
     //! Query if this object is overflowed.
-    //! \return true if overflowed, false if not.
+    //! \return true if a push has failed on a full queue.
     bool isOverflowed()
     {
       return mOverflow;
     }
-    //! Pushes an object onto this stack.
+    //! Pushes an element without waiting.
     //! \param element The element to push.
-    //! \return true if it succeeds, false if it fails.
-    bool push( T& element )
+    //! \return false if the queue was full.
+    bool push( const T& element )
     {
-      ScopedRWLock lock( &mLock );
-      mQueue.push_back( element );
-      if ( !ReleaseSemaphore( mSemaphore, 1, NULL ) )
+      if ( !mRing.tryPush( element ) )
       {
-        mQueue.pop_back();
-        if ( GetLastError() == ERROR_TOO_MANY_POSTS )
-          mOverflow = true;
+        mOverflow = true;
         return false;
       }
+      wake( mPopWaiters, mNotEmpty );
       return true;
     }
-    //! Removes and returns the top-of-stack object.
-    //! \param element The element to pop.
-    //! \return true if it succeeds, false if it fails.
+    //! Pops the oldest element without waiting.
+    //! \param element Receives the popped element.
+    //! \return false if the queue was empty.
     bool pop( T& element )
     {
-      ScopedRWLock lock( &mLock );
-      if ( mQueue.empty() )
-      {
-        while ( WaitForSingleObject( mSemaphore, 0 ) != WAIT_TIMEOUT )
-          1;
+      if ( !mRing.tryPop( element ) )
         return false;
-      }
-      element = mQueue.front();
-      mQueue.pop_front();
+      wake( mPushWaiters, mNotFull );
       return true;
     }
+    //! Pushes an element, sleeping while the queue is full.
+    //! \param element      The element to push.
+    //! \param milliseconds (Optional) Timeout.
+    //! \return false if timed out.
+    bool waitPush( const T& element, DWORD milliseconds = INFINITE )
+    {
+      bool pushed = ( mRing.tryPush( element ) ||
+        park( mPushWaiters, mNotFull, milliseconds,
+          [&]() { return mRing.tryPush( element ); } ) );
+      if ( pushed )
+        wake( mPopWaiters, mNotEmpty );
+      return pushed;
+    }
+    //! Pops the oldest element, sleeping while the queue is empty.
+    //! \param element      Receives the popped element.
+    //! \param milliseconds (Optional) Timeout.
+    //! \return false if timed out.
+    bool waitPop( T& element, DWORD milliseconds = INFINITE )
+    {
+      bool popped = ( mRing.tryPop( element ) ||
+        park( mPopWaiters, mNotEmpty, milliseconds,
+          [&]() { return mRing.tryPop( element ); } ) );
+      if ( popped )
+        wake( mPushWaiters, mNotFull );
+      return popped;
+    }
     //! Clears this object to its blank/initial state.
+    //! Not safe against concurrent pushes.
     void clear()
     {
-      ScopedRWLock lock( &mLock );
-      for ( size_t i = 0; i < mQueue.size(); i++ )
-        WaitForSingleObject( mSemaphore, 0 );
-      mQueue.clear();
+      T element;
+      while ( pop( element ) )
+        ;
       mOverflow = false;
     }
   };
 
+  //! \class BoundedMPSCQueue
+  //! A bounded lock-free multi-producer, single-consumer queue over a
+  //! SequencedRing of fixed capacity.
+  template <typename T, size_t Capacity>
+  class BoundedMPSCQueue: boost::noncopyable {
+    static_assert( Capacity >= 2 && ( Capacity & ( Capacity - 1 ) ) == 0,
+      "Capacity must be a power of two" );
+  protected:
+    SequencedRing<T> mRing; //!< Element storage
+  public:
+    //! Constructor.
+    BoundedMPSCQueue(): mRing( Capacity )
+    {
+    }
+    //! Gets a slot's payload for preallocation.
+    //! Only safe before the queue is in use.
+    T& getSlot( size_t index )
+    {
+      return mRing.getSlot( index );
+    }
+    //! Pushes an element. Safe from any thread.
+    //! \param element The element to push.
+    //! \return false if the queue was full.
+    bool push( const T& element )
+    {
+      return mRing.tryPush( element );
+    }
+    //! Pops the oldest element. Consumer thread only.
+    //! \param element Receives the popped element.
+    //! \return false if the queue was empty.
+    bool pop( T& element )
+    {
+      return mRing.tryPop( element );
+    }
+  };
+
   namespace Utilities
   {
     //! Signal the debugger to give a thread a name
@@ -225,6 +458,22 @@ namespace Glacier {
       return string( &conversion[0] );
     }
 
+    const uint64_t cFNVOffsetBasis = 14695981039346656037ULL;
+    const uint64_t cFNVPrime = 1099511628211ULL;
+
+    //! 64-bit FNV-1a hash, continuing from a previous hash if given.
+    inline uint64_t fnv1a( const void* data, size_t size,
+      uint64_t hash = cFNVOffsetBasis ) throw()
+    {
+      auto bytes = (const uint8_t*)data;
+      for ( size_t i = 0; i < size; i++ )
+      {
+        hash ^= bytes[i];
+        hash *= cFNVPrime;
+      }
+      return hash;
+    }
+
     //! Calculate 64-bit Hamming weight.
     inline int hammingWeight64( uint64_t x ) throw()
     {